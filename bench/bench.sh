@@ -0,0 +1,56 @@
+#!/usr/bin/env bash
+# Run siteupdate across thread counts on a synthetic HighwayData tree
+# made by hwygen, and report throughput & peak RSS for each.
+# usage: bench/bench.sh [-s SYSTEMS] [-r ROUTES] [-p POINTS] [-d DEFECTS]
+#                       [-u USERS] [-l LINES] [-t "THREADCOUNTS"] [-x EXEC]
+# The tree is generated under bench/data the first time a size is used.
+# The defaults make a tree about the size of the real HighwayData;
+# -s 5000 makes one about 10 times that. -u 1000 adds as many .list
+# files as the real UserData has, of -l lines each.
+cd `dirname $0`/..
+s=500; r=40; p=60; d=0; u=0; l=200; x=./siteupdate
+threads="1 2 4 8"
+
+# process commandline args
+while  [ $# -gt 0 ]; do
+  case $1 in
+    -s) s=$2; shift;;
+    -r) r=$2; shift;;
+    -p) p=$2; shift;;
+    -d) d=$2; shift;;
+    -u) u=$2; shift;;
+    -l) l=$2; shift;;
+    -t) threads=$2; shift;;
+    -x) x=$2; shift;;
+    *)  echo "unrecognized argument $1"; exit 1;;
+  esac
+  shift
+done
+
+data=bench/data/s$s-r$r-p$p-d$d-u$u-l$l
+if [ ! -d $data ]; then
+  bench/hwygen -o $data -s $s -r $r -p $p -d $d -u $u -l $l || exit 1
+fi
+
+# a number from the top level of siteupdate.json: the first one with that name
+field() {
+  grep -o "\"$1\": [0-9.]*" $2 | head -n 1 | cut -f2 -d' '
+}
+
+# one untimed run first, so every timed run finds the files in the page cache
+mkdir -p bench/logs/warmup/users
+$x -w $data -u $data/list_files -l bench/logs/warmup > /dev/null || { echo "$x failed"; exit 1; }
+
+printf "%7s %9s %7s %10s %12s %8s %9s\n" threads seconds speedup routes/s waypoints/s MB/s 'RSS MB'
+base=''
+for t in $threads; do
+  logs=bench/logs/t$t
+  rm -fr $logs; mkdir -p $logs/users
+  $x -t $t -w $data -u $data/list_files -l $logs > $logs/siteupdate.log || { echo "$x -t $t failed"; exit 1; }
+  json=$logs/siteupdate.json
+  wall=`field wall_seconds $json`
+  [ -z "$base" ] && base=$wall
+  awk -v t=$t -v w=$wall -v b=$base -v r=`field routes $json` -v p=`field waypoints $json` \
+      -v B=`field bytes $json` -v m=`field peak_rss_kb $json` \
+      'BEGIN {printf "%7d %9.3f %7.2f %10.0f %12.0f %8.1f %9.1f\n", t, w, b/w, r/w, p/w, B/w/1048576, m/1024}'
+done
@@ -0,0 +1,267 @@
+// Tab Width = 8
+
+/* hwygen: write a synthetic HighwayData tree for benchmarking siteupdate.
+
+Writes continents.csv, countries.csv, regions.csv & systems.csv, then
+for each system its chopped & connected route .csv files & a .wpt file
+per chopped route, under hwy_data/<region>/<system>/, and a
+list_files directory for -u, holding -u .list files of -l lines each
+that travel between random labels of the routes written. Output is
+fully determined by the options, so a given size can be regenerated
+anywhere for comparable numbers.
+
+Connected routes cross region boundaries, as in the real data: each
+chopped route begins where the one before it left off. Routes in the
+same region intersect at shared junction points, so colocations are
+found as they would be. With -d, that fraction of points, routes & .csv
+lines, and .list lines, get one of the defects siteupdate checks for.
+
+Random values are taken straight from mt19937_64's output, whose
+sequence the standard fixes, rather than through the <random>
+distributions, which differ between standard libraries; and no
+expression draws more than one of them, as the order its operands are
+evaluated in could differ between compilers.
+*/
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+struct Point
+{	double lat, lng;
+	std::string route;	// the route it's on, to label junctions with
+};
+
+struct Chopped
+{	std::string region, route;
+	std::vector<std::string> labels;	// visible primary labels, for .list lines
+};
+
+static std::mt19937_64 rng;
+
+static double uniform(double lo, double hi)
+{	// the top 53 bits, as a double in [0, 1)
+	return lo + (hi-lo) * ((rng() >> 11) / 9007199254740992.0);
+}
+
+static bool chance(double p)
+{	return uniform(0, 1) < p;
+}
+
+static size_t pick(size_t n)
+{	return rng() % n;
+}
+
+static bool make_dirs(std::string path)
+{	// mkdir -p
+	for (size_t s = path.find('/', 1); ; s = path.find('/', s+1))
+	{	std::string dir = path.substr(0, s);
+		if (mkdir(dir.data(), 0755) && errno != EEXIST) return 0;
+		if (s == std::string::npos) return 1;
+	}
+}
+
+static bool write_file(const std::string &path, const std::string &text)
+{	make_dirs(path.substr(0, path.rfind('/')));
+	FILE *f = fopen(path.data(), "w");
+	if (!f) return 0;
+	fwrite(text.data(), 1, text.size(), f);
+	return !fclose(f);
+}
+
+static std::string letters(size_t n)
+{	// A, B, ... Z, AA, AB ...: a distinct route name prefix for each system
+	std::string s;
+	do {	s.insert(s.begin(), 'A' + n%26);
+		n /= 26;
+	   } while (n--);
+	return s;
+}
+
+static std::string lower(std::string s)
+{	for (char &c : s) if (c >= 'A' && c <= 'Z') c += 32;
+	return s;
+}
+
+static std::string coord(double d)
+{	char s[32];
+	snprintf(s, sizeof(s), "%.6f", d);
+	return s;
+}
+
+static std::string label(size_t pi, const std::string &route, double defects)
+{	/* a label as found in real .wpt files, or now & then a bad one */
+	static const char *roads[] = {"MainSt", "OakAve", "ElmSt", "ParkRd", "RivRd", "MillSt", "ChurSt", "LakeRd"};
+	static const char *bad[] = {"Foo(", "A__B", "Bar/Baz/Qux", "_Lead", "Trail_", "We!rd", "old7", "*",
+				    "VeryLongLabelThatExceedsTheLimit", "ToI-80", "(Lead", "A_B/C"};
+	if (chance(defects)) return bad[pick(sizeof(bad)/sizeof(*bad))];
+	switch (pick(4))
+	{	case 0:  return std::to_string(pi+1) + (chance(0.2) ? "A" : "");
+		case 1:  {	std::string road = roads[pick(sizeof(roads)/sizeof(*roads))];
+				return chance(0.1) ? road + "_N" : road;
+			 }
+		case 2:  return "CR" + std::to_string(1+pick(999));
+		default: return route + "Bus";
+	}
+}
+
+int main(int argc, char *argv[])
+{	std::string out;
+	size_t systems = 100, routes = 40, points = 60, users = 0, lines = 200;
+	double defects = 0;
+	unsigned long seed = 1;
+	for (int n = 1; n < argc; n++)
+	{	if (n+1 < argc && !strcmp(argv[n], "-o")) out = argv[++n];
+		else if (n+1 < argc && !strcmp(argv[n], "-s")) systems = strtoul(argv[++n], 0, 10);
+		else if (n+1 < argc && !strcmp(argv[n], "-r")) routes = strtoul(argv[++n], 0, 10);
+		else if (n+1 < argc && !strcmp(argv[n], "-p")) points = strtoul(argv[++n], 0, 10);
+		else if (n+1 < argc && !strcmp(argv[n], "-d")) defects = strtod(argv[++n], 0);
+		else if (n+1 < argc && !strcmp(argv[n], "-u")) users = strtoul(argv[++n], 0, 10);
+		else if (n+1 < argc && !strcmp(argv[n], "-l")) lines = strtoul(argv[++n], 0, 10);
+		else if (n+1 < argc && !strcmp(argv[n], "-S")) seed = strtoul(argv[++n], 0, 10);
+		else {	out.clear();
+			break;
+		     }
+	}
+	if (out.empty() || !systems || !routes || points < 2)
+	{	printf("usage: %s -o OUTDIR [-s SYSTEMS] [-r ROUTES] [-p POINTS] [-d DEFECTS]\n"
+		       "       [-u USERS] [-l LINES] [-S SEED]\n", argv[0]);
+		printf("  -s  number of systems (default 100)\n");
+		printf("  -r  connected routes per system (default 40)\n");
+		printf("  -p  average points per connected route (default 60)\n");
+		printf("  -d  fraction of points, routes & lines with defects (default 0)\n");
+		printf("  -u  number of .list files (default 0)\n");
+		printf("  -l  lines per .list file (default 200)\n");
+		printf("  -S  random seed (default 1)\n");
+		return 1;
+	}
+	rng.seed(seed);
+	if (!make_dirs(out + "/list_files"))
+	{	printf("Could not create %s\n", out.data());
+		return 1;
+	}
+
+	// 12 countries on 3 continents, 8 regions each, laid out in a grid
+	const size_t countries = 12, regions_per = 8;
+	std::string text = "code;name\nNAM;North America\nEUR;Europe\nASI;Asia\n";
+	write_file(out + "/continents.csv", text);
+	text = "code;name\n";
+	for (size_t c = 0; c < countries; c++)
+		text += 'C' + std::to_string(10+c) + ";Country " + std::to_string(c) + '\n';
+	write_file(out + "/countries.csv", text);
+	std::vector<std::string> regions;
+	text = "code;name;country;continent;regionType\n";
+	for (size_t c = 0; c < countries; c++)
+	  for (size_t r = 0; r < regions_per; r++)
+	  {	regions.push_back('C' + std::to_string(10+c) + '-' + char('A'+r));
+		text += regions.back() + ";Region " + regions.back() + ";C" + std::to_string(10+c) + ';'
+		      + (c < 4 ? "NAM" : c < 8 ? "EUR" : "ASI") + ";State\n";
+	  }
+	write_file(out + "/regions.csv", text);
+	std::vector<std::vector<Point>> junctions(regions.size());
+	std::vector<std::vector<Chopped>> connected;	// in active & preview systems, for .list files
+
+	size_t total_routes = 0, total_points = 0;
+	std::string syslines = "System;CountryCode;Name;Color;Tier;Level\n";
+	for (size_t s = 0; s < systems; s++)
+	{	char sysname[24];
+		snprintf(sysname, sizeof(sysname), "sys%04zu", s);
+		size_t c = s % countries;
+		static const char *levels[] = {"active", "active", "preview", "devel"};
+		syslines += std::string(sysname) + ";C" + std::to_string(10+c) + ";System " + std::to_string(s)
+			  + ";blue;" + std::to_string(1+s%5) + ';' + levels[s%4] + '\n';
+		std::string csv = "System;Region;Route;Banner;Abbrev;City;Root;AltRouteNames\n";
+		std::string con = "System;Route;Banner;GroupName;Roots\n";
+		for (size_t r = 0; r < routes; r++)
+		{	std::string route = letters(s) + std::to_string(r+1);
+			// a connected route, chopped at 1-3 region boundaries
+			size_t first = pick(regions_per), chops = 1 + pick(3);
+			if (first + chops > regions_per) first = regions_per - chops;
+			double lat = 30.0 + 2.5*(c%4) + 2.5*(first/4) + uniform(0, 2);
+			double lng = -120.0 + 8.0*(c/4) + 2.0*(first%4) + uniform(0, 2);
+			std::string roots;
+			if (s%4 != 3) connected.emplace_back();
+			for (size_t k = 0; k < chops; k++)
+			{	size_t rg = c*regions_per + first + k;
+				std::string root = lower(regions[rg]) + '.' + lower(route);
+				roots += (k ? "," : "") + root;
+				std::string line = std::string(sysname) + ';' + regions[rg] + ';' + route + ";;;;" + root
+						 + (r%7 ? ";" : ";" + route + "OLD");
+				if (chance(defects/10)) line.erase(line.rfind(';'));		// wrong field count
+				else if (chance(defects/10)) line.replace(line.find(';'), regions[rg].size()+1, ";QQ");
+				csv += line + '\n';
+				total_routes++;
+				if (chance(defects/5)) continue;				// no .wpt file
+				// the points: a random walk, picking up junctions with earlier routes
+				size_t n = (points + pick(points)) / (2*chops) + 2;
+				if (chance(defects/5)) n = 1;
+				std::vector<Point> &junc = junctions[rg];
+				std::string wpt;
+				Chopped chopped{regions[rg], route, {}};
+				for (size_t i = 0; i < n; i++)
+				{	if (i) {lat += uniform(-0.03, 0.03); lng += uniform(0.01, 0.05);}
+					std::string l;
+					double la = lat, ln = lng;
+					if (i && i < n-1 && junc.size() && chance(0.08))
+					{	Point &j = junc[pick(junc.size())];
+						la = lat = j.lat;
+						ln = lng = j.lng;
+						l = j.route;
+					}
+					else if (i && i < n-1 && chance(0.3)) l = "+X" + std::to_string(100000+pick(900000));
+					else l = label(i, route, defects);
+					if (k && !i) l = regions[rg-1] + '/' + regions[rg];	// the boundary
+					if (i && l[0] != '+' && chance(0.05)) l += " *Old" + l;
+					if (chance(defects/4)) la += uniform(0.5, 1.5);		// long segment
+					if (chance(defects/8)) la = 95.5;			// out of bounds
+					std::string url = "http://www.openstreetmap.org/?lat=" + coord(la);
+					if (!chance(defects/8)) url += "&lon=" + coord(ln);	// else malformed
+					wpt += l + ' ' + url + '\n';
+					if (l[0] != '+') chopped.labels.push_back(l.substr(0, l.find(' ')));
+					if (i && i < n-1 && chance(0.05)) junc.push_back(Point{la, ln, route});
+				}
+				total_points += n;
+				if (s%4 != 3 && chopped.labels.size() > 1) connected.back().push_back(chopped);
+				write_file(out + "/hwy_data/" + regions[rg] + '/' + sysname + '/' + root + ".wpt", wpt);
+			}
+			con += std::string(sysname) + ';' + route + ";;;" + roots + '\n';
+		}
+		write_file(out + "/hwy_data/_systems/" + sysname + ".csv", csv);
+		write_file(out + "/hwy_data/_systems/" + sysname + "_con.csv", con);
+	}
+	write_file(out + "/systems.csv", syslines);
+
+	// .list files: mostly travels along one chopped route, some spanning
+	// two of a connected route, with a defect now & then
+	for (size_t i = connected.size(); i--;)
+	  if (connected[i].empty()) connected.erase(connected.begin()+i);
+	for (size_t u = 0; u < users && connected.size(); u++)
+	{	std::string list = "# synthetic traveler " + std::to_string(u) + '\n';
+		for (size_t i = 0; i < lines; i++)
+		{	std::vector<Chopped> &con = connected[pick(connected.size())];
+			Chopped &a = con[pick(con.size())], &b = con[pick(con.size())];
+			std::string l1 = a.labels[pick(a.labels.size())], l2 = b.labels[pick(b.labels.size())];
+			if (chance(defects))
+			  switch (pick(3))
+			  {	case 0:  list += a.region + " QQ" + a.route + ' ' + l1 + ' ' + l2 + '\n'; continue;
+				case 1:  list += a.region + ' ' + a.route + " NoSuchLabel " + l1 + '\n'; continue;
+				default: list += a.region + ' ' + a.route + ' ' + l1 + '\n'; continue;
+			  }
+			if (&a != &b && chance(0.2))
+				list += a.region + ' ' + a.route + ' ' + l1 + ' ' + b.region + ' ' + b.route + ' ' + l2 + '\n';
+			else {	l2 = a.labels[pick(a.labels.size())];
+				list += a.region + ' ' + a.route + ' ' + l1 + ' ' + l2 + '\n';
+			     }
+		}
+		char name[24];
+		snprintf(name, sizeof(name), "/list_files/u%04zu.list", u);
+		write_file(out + name, list);
+	}
+	printf("%zu systems, %zu routes, %zu points, %zu .list files written to %s\n",
+		systems, total_routes, total_points, users, out.data());
+}
@@ -0,0 +1,310 @@
+// Tab Width = 8
+
+/* microbench: time the waypoint & label hot paths in isolation.
+
+Each kernel runs over a fixed corpus of real-world-shaped .wpt lines,
+labels & .csv lines, built into this file so every run measures the
+same work. A kernel is timed in samples of at least 20 ms; the fastest
+sample's time per operation is reported, which filters out most of the
+noise that swamps single-digit-percent changes end to end.
+
+The label datacheck kernels each run label_datachecks over labels that
+take one check's path, since it's one table-driven pass rather than a
+function per check; "labels clean" is the common case, labels that
+pass every check.
+
+Results are compared against a baseline file. A kernel with no
+baseline yet, as on the first run, has its result added to the file;
+one more than the threshold slower than its baseline fails the run.
+-w replaces the baselines of the kernels run, keeping the others' if
+-k picks only some. Baselines are per machine & build, so they're not
+kept in the repo; delete the file or use -w to start a new one.
+*/
+
+#include "../classes/Arena/Arena.h"
+#include "../classes/Datacheck/Datacheck.h"
+#include "../classes/ErrorList/ErrorList.h"
+#include "../classes/HighwaySystem/HighwaySystem.h"
+#include "../classes/Route/Route.h"
+#include "../classes/Waypoint/Waypoint.h"
+#include "../functions/lower.h"
+#include "../functions/parse_coord.h"
+#include "../functions/split.h"
+#include "../functions/upper.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// .wpt lines as found in real data: exits, junctions, hidden points, alt labels
+static const char *wpt_lines[] =
+{	"NY/MA http://www.openstreetmap.org/?lat=42.403498&lon=-73.353195",
+	"B1 http://www.openstreetmap.org/?lat=42.406219&lon=-73.395080",
+	"B2 *OldB2 http://www.openstreetmap.org/?lat=42.434117&lon=-73.521938",
+	"+X198743 http://www.openstreetmap.org/?lat=42.452370&lon=-73.579788",
+	"B3 http://www.openstreetmap.org/?lat=42.468632&lon=-73.622417",
+	"I-87(21A) http://www.openstreetmap.org/?lat=42.529442&lon=-73.773003",
+	"US9W_S http://www.openstreetmap.org/?lat=42.597523&lon=-73.781452",
+	"1A http://www.openstreetmap.org/?lat=42.651840&lon=-73.784065",
+	"+X385021 http://www.openstreetmap.org/?lat=42.667419&lon=-73.795216",
+	"2 http://www.openstreetmap.org/?lat=42.695713&lon=-73.810356",
+	"3 +3A http://www.openstreetmap.org/?lat=42.704823&lon=-73.836578",
+	"NY155 http://www.openstreetmap.org/?lat=42.717941&lon=-73.852806",
+	"4 http://www.openstreetmap.org/?lat=42.734081&lon=-73.878212",
+	"5 http://www.openstreetmap.org/?lat=42.758923&lon=-73.911468",
+	"+X777215 http://www.openstreetmap.org/?lat=42.781342&lon=-73.941345",
+	"6 http://www.openstreetmap.org/?lat=42.800236&lon=-73.960403",
+	"7 http://www.openstreetmap.org/?lat=42.817535&lon=-74.001122",
+	"CR158 http://www.openstreetmap.org/?lat=42.843449&lon=-74.063782",
+	"8 http://www.openstreetmap.org/?lat=42.862137&lon=-74.118752",
+	"MainSt http://www.openstreetmap.org/?lat=42.885784&lon=-74.195312",
+	"NY30A/NY5S http://www.openstreetmap.org/?lat=42.932919&lon=-74.371376&zoom=15",
+	"28 http://www.openstreetmap.org/?lat=42.946289&lon=-74.623764",
+	"OldMillRd http://www.openstreetmap.org/?lat=42.963646&lon=-74.827079",
+	"29A http://www.openstreetmap.org/?lat=43.021278&lon=-74.986999",
+	"30 http://www.openstreetmap.org/?lat=43.051678&lon=-75.142227",
+	"I-790 http://www.openstreetmap.org/?lat=43.093224&lon=-75.269798",
+	"+X113001 http://www.openstreetmap.org/?lat=43.104237&lon=-75.302101",
+	"32 http://www.openstreetmap.org/?lat=43.110397&lon=-75.384178",
+	"33 http://www.openstreetmap.org/?lat=43.108562&lon=-75.590088",
+	"US11 http://www.openstreetmap.org/?lat=43.060398&lon=-76.104561",
+	"I-81 *I-81(25A) http://www.openstreetmap.org/?lat=43.073944&lon=-76.162643",
+	"+X507766 http://www.openstreetmap.org/?lat=43.080597&lon=-76.232788",
+	"39 http://www.openstreetmap.org/?lat=43.088764&lon=-76.285400",
+	"40 http://www.openstreetmap.org/?lat=43.011147&lon=-76.581680",
+	"NY14_N http://www.openstreetmap.org/?lat=42.994236&lon=-76.983612",
+	"45 http://www.openstreetmap.org/?lat=43.023342&lon=-77.451912",
+	"I-490_E http://www.openstreetmap.org/?lat=43.046947&lon=-77.507263",
+	"+X920175 http://www.openstreetmap.org/?lat=43.034145&lon=-77.603630",
+	"46 http://www.openstreetmap.org/?lat=43.041172&lon=-77.680664",
+	"NY/PA http://www.openstreetmap.org/?lat=42.046230&lon=-79.761200"
+};
+
+// labels taking each label datacheck's path, for a Route I-90 in the USA
+static const std::map<std::string, std::vector<const char*>> check_labels =
+{	{"clean",		{"1A", "NY5_W", "US20", "MainSt", "CR158", "I-87(21A)", "29A", "NY30A/NY5S"}},
+	{"invalid_char",	{"We!rd", "*", "A,B", "\xEF\xBB\xBF" "BOM", "Foo+Bar", "Rd;Ave", "Exit#4", "[2]"}},
+	{"bus_with_i",		{"I-80Bus", "I-81BUS", "*I-90EBus", "I-5bus", "I-84Bus_N", "I-70WBus", "I-25Bus", "I-10Bus"}},
+	{"interstate_no_hyphen",{"I95", "ToI80", "*I81", "I5", "I490_E", "ToI87", "I790", "I10"}},
+	{"us_letter",		{"US1A", "US20B", "US9A_N", "US11B/NY5", "US6Ait", "US62B(10)", "*US4A", "US202A"}},
+	{"first_final_char",	{"_Lead", "/Lead", "(Lead", "Trail_", "Trail/", "*_Lead", "Mid/", "x_"}},
+	{"looks_hidden",	{"X123456", "X000001", "X654321", "X999999", "X100200", "X314159", "X271828", "X161803"}},
+	{"parens",		{"Foo(", "Foo)(", "A(1)(2)", "B)", "(C", "D(E(F)", "G)H(", "I((J))"}},
+	{"selfref",		{"I-90", "I-90_W", "US20/90", "NY5/I-90", "I-90/NY5", "US9/90_N", "I-90/US20", "A/90"}},
+	{"slashes",		{"Bar/Baz/Qux", "A/B/C", "US1/US9/NY5", "X/Y/Z_N", "1/2/3", "NY7/NY2/US4", "A/B/C/D", "E/F/G"}},
+	{"lacks_generic",	{"Old12", "old7", "OLD5", "*Old20", "Old9_S", "oLd3", "Old100", "Old1/Old2"}},
+	{"underscores",		{"A_B_C", "Foo_Road", "US1_Bus_N", "NY5_Old", "A_B/C", "I-87_Exit", "X_Y_Z", "Main_Street"}}
+};
+
+// .csv lines for split
+static const char *csv_lines[] =
+{	"usai;NY;I-90;;;;ny.i090;",
+	"usaus;NY;US9;Bus;Pou;Poughkeepsie;ny.us009buspou;US9BusPou,US9Bus",
+	"usany;NY;NY5;;;;ny.ny005;NY5S",
+	"cannb;NB;NB1;;;;nb.nb001;",
+	"deua;BW;A5;;;;bw.a005;E35,E52",
+	"usaca;CA;CA1;;;;ca.ca001;"
+};
+
+// Route & root names for lower & upper
+static const char *names[] =
+{	"NY.I090", "ny.us009buspou", "Pa.Us322BusHar", "BW.A005", "ca.CA001", "QC.A020", "nb.nb001", "FL.US001ALT"
+};
+
+struct Kernel
+{	std::string name;
+	size_t ops;			// per call of run
+	std::function<void()> run;
+};
+
+static double ns_per_op(Kernel &k)
+{	/* the fastest of 7 samples of at least 20 ms each */
+	using namespace std::chrono;
+	size_t reps = 1;
+	double best = 1e300;
+	for (int sample = 0; sample < 7;)
+	{	steady_clock::time_point start = steady_clock::now();
+		for (size_t r = 0; r < reps; r++) k.run();
+		double ns = duration_cast<duration<double, std::nano>>(steady_clock::now() - start).count();
+		if (ns < 2e7)
+		{	reps *= 2;
+			continue;
+		}
+		if (ns/reps/k.ops < best) best = ns/reps/k.ops;
+		sample++;
+	}
+	return best;
+}
+
+int main(int argc, char *argv[])
+{	std::string baseline = "bench/microbench.baseline";
+	double threshold = 10;
+	bool rewrite = 0;
+	std::string only;
+	for (int n = 1; n < argc; n++)
+	{	if (n+1 < argc && !strcmp(argv[n], "-b")) baseline = argv[++n];
+		else if (n+1 < argc && !strcmp(argv[n], "-T")) threshold = strtod(argv[++n], 0);
+		else if (n+1 < argc && !strcmp(argv[n], "-k")) only = argv[++n];
+		else if (!strcmp(argv[n], "-w")) rewrite = 1;
+		else {	printf("usage: %s [-b BASELINE] [-T PERCENT] [-k KERNEL] [-w]\n", argv[0]);
+			printf("  -b  baseline file (default bench/microbench.baseline)\n");
+			printf("  -T  fail when a kernel is more than this percent slower (default 10)\n");
+			printf("  -k  run only kernels whose names contain KERNEL\n");
+			printf("  -w  write new baselines for the kernels run instead of comparing\n");
+			return 1;
+		     }
+	}
+
+	// a Route for Waypoints to belong to; its system's .csv files
+	// needn't exist, as that just leaves a quiet error behind
+	std::vector<std::pair<std::string,std::string>> countries{{"USA", "United States"}};
+	std::string sysline = "usai;USA;Interstate;blue;1;active";
+	std::string rteline = "usai;NY;I-90;;;;ny.i090;";
+	ErrorList el;
+	el.quiet = 1;
+	HighwaySystem *sys = new HighwaySystem(sysline, countries);
+	Route *rte = new Route(rteline, sys, el);
+	Waypoint::LabelContext lc(rte, 1);
+	std::vector<Kernel> kernels;
+
+	// Waypoint constructor; each is freed right away, labels & all, so the Arena doesn't grow
+	const size_t lines = sizeof(wpt_lines)/sizeof(*wpt_lines);
+	kernels.push_back(Kernel{"Waypoint ctor", lines, [&]()
+	{	for (const char *l : wpt_lines)
+		{	Waypoint *w = new Waypoint(l, l+strlen(l), rte);
+			// labels were allocated after the object, so they go first
+			Arena::deallocate((void*)w->label, w->labels_size());
+			delete w;
+		}
+		rte->lat.clear();
+		rte->lng.clear();
+		Datacheck::thread_buffer().clear();
+	}});
+
+	// parse_coord, on each URL's lat & lon
+	std::vector<std::pair<const char*, const char*>> coords;
+	for (const char *l : wpt_lines)
+	{	const char *end = l+strlen(l);
+		coords.emplace_back(strstr(l, "lat=")+4, end);
+		coords.emplace_back(strstr(l, "lon=")+4, end);
+	}
+	kernels.push_back(Kernel{"parse_coord", coords.size(), [&]()
+	{	double d;
+		for (auto &c : coords) parse_coord(c.first, c.second, d);
+	}});
+
+	// split
+	std::vector<std::string> csv(csv_lines, csv_lines+sizeof(csv_lines)/sizeof(*csv_lines));
+	kernels.push_back(Kernel{"split", csv.size(), [&]()
+	{	std::string f[8];
+		std::string* fields[8] = {f, f+1, f+2, f+3, f+4, f+5, f+6, f+7};
+		for (std::string &l : csv)
+		{	size_t NumFields = 8;
+			split(l, fields, NumFields, ';');
+		}
+	}});
+
+	// lower & upper, each on a fresh copy of mixed-case names
+	const size_t num_names = sizeof(names)/sizeof(*names);
+	char scratch[32];
+	kernels.push_back(Kernel{"lower", num_names, [&]()
+	{	for (const char *n : names) lower(strcpy(scratch, n));
+	}});
+	kernels.push_back(Kernel{"upper", num_names, [&]()
+	{	for (const char *n : names) upper(strcpy(scratch, n));
+	}});
+
+	// the coordinates of the corpus, as one Route, for distance, angle & geometry
+	Route *path = new Route(rteline, sys, el);
+	for (const char *l : wpt_lines) new Waypoint(l, l+strlen(l), path);
+	std::vector<double> &lat = path->lat, &lng = path->lng;
+	kernels.push_back(Kernel{"Waypoint::distance", lat.size()-1, [&]()
+	{	for (size_t i = 1; i < lat.size(); i++) Waypoint::distance(lat[i-1], lng[i-1], lat[i], lng[i]);
+	}});
+	kernels.push_back(Kernel{"Waypoint::angle", lat.size()-2, [&]()
+	{	for (size_t i = 1; i+1 < lat.size(); i++)
+			Waypoint::angle(lat[i-1], lng[i-1], lat[i], lng[i], lat[i+1], lng[i+1]);
+	}});
+	std::vector<double> lengths, angles;
+	kernels.push_back(Kernel{"Route::geometry (per point)", lat.size(), [&]()
+	{	path->geometry(lengths, angles);
+	}});
+
+	// label_datachecks, one kernel per check, over Waypoints made once
+	for (auto &c : check_labels)
+	{	std::vector<Waypoint*> points;
+		for (const char *label : c.second)
+		{	std::string line = std::string(label) + " http://www.openstreetmap.org/?lat=42.652580&lon=-73.756233";
+			points.push_back(new Waypoint(line.data(), line.data()+line.size(), rte));
+		}
+		kernels.push_back(Kernel{"labels " + c.first, points.size(), [points, &lc]()
+		{	for (Waypoint *w : points) w->label_datachecks(lc);
+			Datacheck::thread_buffer().clear();
+		}});
+	}
+	kernels.push_back(Kernel{"label_too_long", check_labels.at("clean").size(), [&]()
+	{	for (const char *label : check_labels.at("clean"))
+		{	Waypoint w(rte, 0, 0, label, 0);
+			w.label_too_long();
+		}
+		rte->lat.clear();
+		rte->lng.clear();
+	}});
+
+	// read the baseline; with -w, only to keep the kernels -k leaves out
+	std::map<std::string, double> base;
+	std::ifstream in(baseline);
+	if ((!rewrite || only.size()) && in)
+	{	std::string line;
+		while (getline(in, line))
+		{	size_t tab = line.rfind('\t');
+			if (tab != std::string::npos) base[line.substr(0, tab)] = strtod(line.data()+tab+1, 0);
+		}
+	}
+	in.close();
+
+	// run & compare, merging new results into what was read
+	size_t regressions = 0;
+	std::map<std::string, double> merged = base;
+	bool writing = 0;
+	printf("%-30s %10s %10s %8s\n", "kernel", "ns/op", "baseline", "change");
+	for (Kernel &k : kernels)
+	{	if (only.size() && k.name.find(only) == std::string::npos) continue;
+		double ns = ns_per_op(k);
+		auto b = base.find(k.name);
+		if (rewrite || b == base.end())
+		{	merged[k.name] = ns;
+			writing = 1;
+			printf("%-30s %10.2f %10s %8s\n", k.name.data(), ns, "-", "-");
+			continue;
+		}
+		double change = (ns/b->second - 1) * 100;
+		bool regressed = change > threshold;
+		regressions += regressed;
+		printf("%-30s %10.2f %10.2f %+7.1f%%%s\n", k.name.data(), ns, b->second, change, regressed ? "  REGRESSION" : "");
+	}
+
+	if (writing)
+	{	std::ofstream out(baseline);
+		char line[64];
+		for (auto &m : merged)
+		{	snprintf(line, sizeof(line), "%s\t%.3f\n", m.first.data(), m.second);
+			out << line;
+		}
+		if (!out)
+		{	printf("Could not write %s\n", baseline.data());
+			return 1;
+		}
+		printf("Baseline written to %s\n", baseline.data());
+	}
+	if (regressions)
+	{	printf("%zu kernel(s) more than %g%% slower than %s\n", regressions, threshold, baseline.data());
+		return 1;
+	}
+	return 0;
+}
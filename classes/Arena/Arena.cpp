@@ -0,0 +1,85 @@
+#include "Arena.h"
+#include <cstdlib>
+#include <new>
+
+#define BLOCKSIZE 0x400000	// 4 MiB
+#define ALIGNMENT alignof(std::max_align_t)
+
+thread_local Arena *Arena::current = 0;
+std::mutex Arena::mtx;
+std::vector<Arena*> Arena::arenas;
+
+Arena::Arena()
+{	next = 0;
+	end = 0;
+	bytes = 0;
+	objects = 0;
+}
+
+size_t Arena::rounded(size_t size)
+{	// the space an allocation of size bytes really takes
+	return (size + ALIGNMENT-1) & ~(ALIGNMENT-1);
+}
+
+void *Arena::alloc(size_t size)
+{	size = rounded(size);
+	if (size > size_t(end-next))
+	{	// oversized requests get a block of their own; the current block stays in use
+		if (size > BLOCKSIZE/4)
+		{	char *b = (char*)malloc(size);
+			if (!b) throw std::bad_alloc();
+			blocks.push_back(b);
+			bytes += size;
+			objects++;
+			return blocks.back();
+		}
+		char *b = (char*)malloc(BLOCKSIZE);
+		if (!b) throw std::bad_alloc();
+		blocks.push_back(b);
+		next = b;
+		end = next + BLOCKSIZE;
+	}
+	void *p = next;
+	next += size;
+	bytes += size;
+	objects++;
+	return p;
+}
+
+void Arena::free(void *p, size_t size)
+{	/* reclaim the space only if it was the most recent allocation;
+	otherwise it stays in the block until release_all */
+	size = rounded(size);
+	if ((char*)p + size == next)
+	{	next = (char*)p;
+		bytes -= size;
+		objects--;
+	}
+}
+
+void *Arena::allocate(size_t size)
+{	/* allocate from the calling thread's Arena, creating it if needed */
+	if (!current)
+	{	current = new Arena;
+		mtx.lock();
+		arenas.push_back(current);
+		mtx.unlock();
+	}
+	return current->alloc(size);
+}
+
+void Arena::deallocate(void *p, size_t size)
+{	if (current) current->free(p, size);
+}
+
+void Arena::release_all()
+{	for (Arena *a : arenas)
+	{	for (char *b : a->blocks) ::free(b);
+		delete a;
+	}
+	arenas.clear();
+	current = 0;
+}
+
+#undef BLOCKSIZE
+#undef ALIGNMENT
@@ -0,0 +1,34 @@
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+class Arena
+{	/* A bump allocator for objects that are never deleted individually,
+	but live until the program terminates. Each thread allocates from
+	its own Arena, created on first use, so no locking is needed after
+	that. At exit, release_all frees every block of every Arena at
+	once; destructors are not run.
+
+	bytes & objects count what has been handed out from this Arena;
+	every allocation takes its size rounded up by rounded.
+	*/
+	std::vector<char*> blocks;
+	char *next, *end;
+
+	static thread_local Arena *current;
+	static std::mutex mtx;		// for locking the arenas list when a thread creates its Arena
+
+	public:
+	size_t bytes, objects;
+
+	static std::vector<Arena*> arenas;
+
+	Arena();
+	void *alloc(size_t);
+	void free(void *, size_t);
+
+	static size_t rounded(size_t);
+	static void *allocate(size_t);
+	static void deallocate(void *, size_t);
+	static void release_all();
+};
@@ -17,6 +17,9 @@
 /* n */ std::string Args::nmpmergepath = "";
 /* p */ std::string Args::splitregionpath = "";
 /* p */ std::string Args::splitregion;
+/* S */ std::string Args::snapshotfile = "";
+/* i */ std::list<std::string> Args::changedfiles;
+/* I */ std::string Args::changedlistfile = "";
 /* U */ std::list<std::string> Args::userlist;
 const char* Args::exec;
 
@@ -40,6 +43,8 @@ bool Args::init(int argc, char *argv[])
 		else if ARG(1, "-c", "--csvstatfilepath")	{csvstatfilepath  = argv[n+1]; n++;}
 		else if ARG(1, "-g", "--graphfilepath")		{graphfilepath    = argv[n+1]; n++;}
 		else if ARG(1, "-n", "--nmpmergepath")		{nmpmergepath     = argv[n+1]; n++;}
+		else if ARG(1, "-S", "--snapshot")		{snapshotfile     = argv[n+1]; n++;}
+		else if ARG(1, "-I", "--changedlist")		{changedlistfile  = argv[n+1]; n++;}
 		else if ARG(1, "-t", "--numthreads")
 		{	numthreads = strtol(argv[n+1], 0, 10);
 			if (numthreads<1) numthreads=1;
@@ -56,6 +61,11 @@ bool Args::init(int argc, char *argv[])
 			{	userlist.push_back(argv[n+1]);
 				n++;
 			}
+		else if ARG(1, "-i", "--changed")
+			while (n+1 < argc && argv[n+1][0] != '-')
+			{	changedfiles.push_back(argv[n+1]);
+				n++;
+			}
 		else if ARG(2, "-p", "--splitregion")
 		{	splitregionpath = argv[n+1];
 			splitregion = argv[n+2];
@@ -73,7 +83,8 @@ void Args::show_help()
 	std::cout  <<  indent << "        [-c CSVSTATFILEPATH] [-g GRAPHFILEPATH] [-k]\n";
 	std::cout  <<  indent << "        [-n NMPMERGEPATH] [-p SPLITREGIONPATH SPLITREGION]\n";
 	std::cout  <<  indent << "        [-U USERLIST [USERLIST ...]] [-t NUMTHREADS] [-e]\n";
-	std::cout  <<  indent << "        [-T TIMEPRECISION] [-v]\n";
+	std::cout  <<  indent << "        [-T TIMEPRECISION] [-v] [-C] [-S SNAPSHOTFILE]\n";
+	std::cout  <<  indent << "        [-i CHANGED [CHANGED ...]] [-I CHANGEDLIST]\n";
 	std::cout  <<  "\n";
 	std::cout  <<  "Create SQL, stats, graphs, and log files from highway and user data for the\n";
 	std::cout  <<  "Travel Mapping project.\n";
@@ -115,4 +126,16 @@ void Args::show_help()
 	std::cout  <<  "		        timestamp readouts\n";
 	std::cout  <<  "  -v, --mt-vertices     Multi-threaded vertex construction\n";
 	std::cout  <<  "  -C, --mt-csvs         Multi-threaded stats csv files\n";
+	std::cout  <<  "  -S SNAPSHOTFILE, --snapshot SNAPSHOTFILE\n";
+	std::cout  <<  "		        Binary snapshot of parsed .wpt data, reused for\n";
+	std::cout  <<  "		        unchanged files & rewritten after loading\n";
+	std::cout  <<  "  -i CHANGED [CHANGED ...], --changed CHANGED [CHANGED ...]\n";
+	std::cout  <<  "		        Incremental mode: files changed since the snapshot\n";
+	std::cout  <<  "		        was written, relative to HIGHWAYDATAPATH. Other\n";
+	std::cout  <<  "		        .wpt files are taken from the snapshot unchecked.\n";
+	std::cout  <<  "		        Colocations & .list files are still processed in\n";
+	std::cout  <<  "		        full. Requires -S.\n";
+	std::cout  <<  "  -I CHANGEDLIST, --changedlist CHANGEDLIST\n";
+	std::cout  <<  "		        As -i, reading the changed files from CHANGEDLIST,\n";
+	std::cout  <<  "		        one per line (e.g. git diff --name-only output)\n";
 }
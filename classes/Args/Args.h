@@ -19,6 +19,9 @@ class Args
 	/* T */ static int timeprecision;
 	/* v */ static bool mtvertices;
 	/* C */ static bool mtcsvfiles;
+	/* S */ static std::string snapshotfile;
+	/* i */ static std::list<std::string> changedfiles;
+	/* I */ static std::string changedlistfile;
 		static const char* exec;
 
 	static bool init(int argc, char *argv[]);
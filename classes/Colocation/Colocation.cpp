@@ -0,0 +1,172 @@
+#include "Colocation.h"
+#include "../Arena/Arena.h"
+#include "../Datacheck/Datacheck.h"
+#include "../HighwaySystem/HighwaySystem.h"
+#include "../Route/Route.h"
+#include "../Waypoint/Waypoint.h"
+#include "../../functions/coord_hash.h"
+#include <string>
+
+std::vector<Route*> Colocation::routes;
+std::vector<std::vector<Waypoint*>> Colocation::buckets;
+std::vector<std::vector<Colocation*>> Colocation::tables(Colocation::shards);
+size_t Colocation::chunks = 0;
+
+// the top bits pick the shard, the bottom bits the slot
+static inline size_t shard_of(uint64_t h)
+{	return h >> 56;
+}
+
+void Colocation::setup(size_t numchunks)
+{	/* list every Route & make numchunks chunks' worth of empty buckets */
+	for (HighwaySystem *h : HighwaySystem::syslist)
+		routes.insert(routes.end(), h->route_list.begin(), h->route_list.end());
+	chunks = numchunks;
+	buckets.resize(chunks*shards);
+}
+
+void Colocation::bucket(size_t c)
+{	/* sort the points of chunk c's Routes into its buckets */
+	size_t beg = routes.size() * c / chunks;
+	size_t end = routes.size() * (c+1) / chunks;
+	for (size_t r = beg; r < end; r++)
+	  for (unsigned int i = 0; i < routes[r]->point_list.size(); i++)
+	  {	uint64_t h = coord_hash(routes[r]->lat[i], routes[r]->lng[i]);
+		buckets[c*shards + shard_of(h)].push_back(routes[r]->point_list[i]);
+	  }
+}
+
+void Colocation::group(size_t s)
+{	/* group the points in shard s by location, make a Colocation
+	for each location with more than one, then run its datachecks */
+	struct Location
+	{	double lat, lng;
+		unsigned int count;	// 0 if this slot is empty
+		Colocation *coloc;
+	};
+	size_t points = 0;
+	for (size_t c = 0; c < chunks; c++) points += buckets[c*shards + s].size();
+	size_t capacity = 16;
+	while (capacity < 2*points) capacity *= 2;
+	std::vector<Location> locs(capacity);
+	auto location = [&](Waypoint *w) -> Location&
+	{	// w's slot, claimed for its coordinates if need be
+		double lat = w->lat(), lng = w->lng();
+		size_t i = coord_hash(lat, lng) & (capacity-1);
+		while (locs[i].count && (locs[i].lat != lat || locs[i].lng != lng)) i = (i+1) & (capacity-1);
+		locs[i].lat = lat;
+		locs[i].lng = lng;
+		return locs[i];
+	};
+
+	// count points per location
+	size_t groups = 0;
+	for (size_t c = 0; c < chunks; c++)
+	  for (Waypoint *w : buckets[c*shards + s])
+	    if (++location(w).count == 2) groups++;
+	// make a Colocation for each location with more than one point
+	std::vector<Colocation*> &table = tables[s];
+	size_t table_cap = 16;
+	while (table_cap < 2*groups) table_cap *= 2;
+	table.assign(groups ? table_cap : 0, 0);
+	std::vector<Colocation*> made;
+	made.reserve(groups);
+	for (Location &loc : locs)
+	  if (loc.count > 1)
+	  {	Colocation *col = new Colocation;
+		col->lat = loc.lat;
+		col->lng = loc.lng;
+		col->points = (Waypoint**)Arena::allocate(loc.count*sizeof(Waypoint*));
+		col->ap_coloc = 0;
+		col->count = 0;
+		col->ap_count = 0;
+		loc.coloc = col;
+		made.push_back(col);
+		size_t i = coord_hash(loc.lat, loc.lng) & (table_cap-1);
+		while (table[i]) i = (i+1) & (table_cap-1);
+		table[i] = col;
+	  }
+	// fill them in, in chunk order & thus system, route & point order
+	for (size_t c = 0; c < chunks; c++)
+	  for (Waypoint *w : buckets[c*shards + s])
+	    if (Colocation *col = location(w).coloc)
+	    {	col->points[col->count++] = w;
+		if (w->route->system->active_or_preview()) col->ap_count++;
+	    }
+	for (Colocation *col : made)
+	{	if (col->ap_count)
+		{	col->ap_coloc = (Waypoint**)Arena::allocate(col->ap_count*sizeof(Waypoint*));
+			unsigned int a = 0;
+			for (unsigned int p = 0; p < col->count; p++)
+			  if (col->points[p]->route->system->active_or_preview())
+				col->ap_coloc[a++] = col->points[p];
+		}
+		col->datachecks();
+	}
+	for (size_t c = 0; c < chunks; c++)
+		std::vector<Waypoint*>().swap(buckets[c*shards + s]);
+}
+
+void Colocation::datachecks()
+{	/* checks for locations that would be a vertex of the
+	TM master graph, i.e., have a point in an active or preview system */
+	if (!ap_count) return;
+	// visible & hidden points at the same location:
+	// flag the first visible point, with the first hidden point as info
+	Waypoint *vis = 0, *hid = 0;
+	for (unsigned int p = 0; p < count; p++)
+	  if (points[p]->is_hidden)	{ if (!hid) hid = points[p]; }
+	  else				{ if (!vis) vis = points[p]; }
+	if (vis && hid)
+	{	Datacheck::add(vis->route, vis->label, "", "", Datacheck::VISIBLE_HIDDEN_COLOC,
+			       (hid->route->root + '@' + hid->label).data());
+		return;
+	}
+	if (vis) return;
+	// all hidden: a junction of more than 2 edges, one per neighboring
+	// location along active & preview routes' segments. A segment back
+	// to this same location is a loop, incident at both ends.
+	std::vector<std::pair<double, double>> neighbors;
+	bool loop = 0;
+	for (unsigned int a = 0; a < ap_count; a++)
+	{	Route *r = ap_coloc[a]->route;
+		unsigned int i = ap_coloc[a]->point_num;
+		for (unsigned int n : {i-1, i+1})	// i-1 wraps around past 0, failing n < size
+		  if (n < r->point_list.size())
+		  {	std::pair<double, double> coords(r->lat[n], r->lng[n]);
+			if (coords.first == lat && coords.second == lng) loop = 1;
+			else {	bool seen = 0;
+				for (std::pair<double, double> &c : neighbors)
+				  if (c.first == coords.first && c.second == coords.second)
+				  {	seen = 1;
+					break;
+				  }
+				if (!seen) neighbors.push_back(coords);
+			     }
+		  }
+	}
+	size_t edges = neighbors.size() + 2*loop;
+	if (edges > 2)
+		Datacheck::add(points[0]->route, points[0]->label, "", "", Datacheck::HIDDEN_JUNCTION, std::to_string(edges).data());
+}
+
+Colocation* Colocation::find(double lat, double lng)
+{	/* return the Colocation at lat,lng, or 0 if fewer than 2 points are there */
+	uint64_t h = coord_hash(lat, lng);
+	std::vector<Colocation*> &table = tables[shard_of(h)];
+	if (table.empty()) return 0;
+	for (size_t i = h & (table.size()-1); table[i]; i = (i+1) & (table.size()-1))
+	  if (table[i]->lat == lat && table[i]->lng == lng) return table[i];
+	return 0;
+}
+
+size_t Colocation::total()
+{	size_t n = 0;
+	for (std::vector<Colocation*> &table : tables)
+	  for (Colocation *c : table) n += c != 0;
+	return n;
+}
+
+void* Colocation::operator new(size_t size)
+{	return Arena::allocate(size);
+}
@@ -0,0 +1,43 @@
+class Route;
+class Waypoint;
+#include <cstddef>
+#include <vector>
+
+class Colocation
+{	/* The waypoints at one exact location, across every route.
+	Only locations with two or more points get one.
+
+	points is every waypoint here, in system, route & point order;
+	ap_coloc is those in active or preview systems, in the same order.
+	Both arrays are allocated from the Arena, like the object itself.
+
+	Colocations are found in parallel, with the coordinates hashed into
+	shards. First each chunk of Routes sorts its points into per-shard
+	buckets (bucket); then each shard groups its points on its own
+	(group), taking the chunks' buckets in order, so each group's points
+	are in the same order no matter how many threads ran. Each shard
+	keeps a table of its Colocations for find, and runs the datachecks
+	that depend on them as it goes.
+	*/
+	static std::vector<Route*> routes;		// every Route, in system & route order
+	static std::vector<std::vector<Waypoint*>> buckets;	// [chunk*shards + shard]
+	static std::vector<std::vector<Colocation*>> tables;	// [shard], open addressing
+
+	void datachecks();
+
+	public:
+	double lat, lng;
+	Waypoint **points;
+	Waypoint **ap_coloc;
+	unsigned int count, ap_count;
+
+	static const size_t shards = 256;
+	static size_t chunks;
+
+	static void setup(size_t);
+	static void bucket(size_t);
+	static void group(size_t);
+	static Colocation* find(double, double);
+	static size_t total();
+	static void* operator new(size_t);	// allocated from the calling thread's Arena
+};
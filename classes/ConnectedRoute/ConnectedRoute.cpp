@@ -1,7 +1,9 @@
 #include "ConnectedRoute.h"
+#include "../Arena/Arena.h"
 #include "../DBFieldLength/DBFieldLength.h"
 #include "../ErrorList/ErrorList.h"
 #include "../HighwaySystem/HighwaySystem.h"
+#include "../NameTable/NameTable.h"
 #include "../Route/Route.h"
 #include "../../functions/lower.h"
 #include "../../functions/split.h"
@@ -12,7 +14,7 @@ ConnectedRoute::ConnectedRoute(std::string &line, HighwaySystem *sys, ErrorList
 	// parse chopped routes csv line
 	system = sys;
 	size_t NumFields = 5;
-	std::string sys_str, roots_str;
+	std::string sys_str;
 	std::string* fields[5] = {&sys_str, &route, &banner, &groupname, &roots_str};
 	split(line, fields, NumFields, ';');
 	if (NumFields != 5)
@@ -36,16 +38,23 @@ ConnectedRoute::ConnectedRoute(std::string &line, HighwaySystem *sys, ErrorList
 	if (groupname.size() > DBFieldLength::city)
 		el.add_error("groupname > " + std::to_string(DBFieldLength::city)
 			   + " bytes in " + system->systemname + "_con.csv line: " + line);
-	// roots
+	// roots, to be found by find_roots
 	lower(roots_str.data());
+	this->line = line;
+}
+
+void ConnectedRoute::find_roots(ErrorList &el)
+{	/* look up the Routes named in roots_str; once all systems
+	before this one have their Routes in Route::root_hash */
+	if (line.empty()) return; // the .csv line couldn't be parsed
 	int rootOrder = 0;
 	size_t l = 0;
 	for (size_t r = 0; r != -1; l = r+1)
 	{	r = roots_str.find(',', l);
-		try {	Route *root = Route::root_hash.at(roots_str.substr(l, r-l));
-			roots.push_back(root);
+		if (Route *root = Route::root_hash.find(roots_str.data()+l, (r == -1 ? roots_str.size() : r) - l))
+		{	roots.push_back(root);
 			if (root->con_route)
-			  el.add_error("Duplicate root in " + sys->systemname + "_con.csv: " + root->root +
+			  el.add_error("Duplicate root in " + system->systemname + "_con.csv: " + root->root +
 				       " already in " + root->con_route->system->systemname + "_con.csv");
 			if (system != root->system)
 			  el.add_error("System mismatch: chopped route " + root->root + " from " + root->system->systemname +
@@ -54,11 +63,19 @@ ConnectedRoute::ConnectedRoute(std::string &line, HighwaySystem *sys, ErrorList
 			// save order of route in connected route
 			root->rootOrder = rootOrder;
 			rootOrder++;
-		    }
-		catch (std::out_of_range& oor)
-		    {	el.add_error("Could not find Route matching ConnectedRoute root " + roots_str.substr(l, r-l) +
-					" in system " + system->systemname + '.');
-		    }
+		}
+		else	el.add_error("Could not find Route matching ConnectedRoute root " + roots_str.substr(l, r-l) +
+				     " in system " + system->systemname + '.');
 	}
 	if (roots.size() < 1) el.add_error("No valid roots in " + system->systemname + "_con.csv line: " + line);
+	std::string().swap(line);
+	std::string().swap(roots_str);
+}
+
+void* ConnectedRoute::operator new(size_t size)
+{	return Arena::allocate(size);
+}
+
+void ConnectedRoute::operator delete(void* p, size_t size)
+{	Arena::deallocate(p, size);
 }
@@ -15,8 +15,12 @@ class ConnectedRoute
 	std::string banner;
 	std::string groupname;
 	std::vector<Route*> roots;
+	std::string line, roots_str;	// .csv line & its lowercased roots field, until find_roots
 
 	double mileage; // will be computed for routes in active & preview systems
 
 	ConnectedRoute(std::string &, HighwaySystem *, ErrorList &);
+	void find_roots(ErrorList &);
+	static void* operator new(size_t);		// allocated from the calling thread's Arena
+	static void operator delete(void*, size_t);	// reclaimed only if it was the Arena's last allocation
 };
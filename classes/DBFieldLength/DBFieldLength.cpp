@@ -1,22 +1,22 @@
 #include "DBFieldLength.h"
 
 // constants
-const size_t DBFieldLength::abbrev = 3;
-const size_t DBFieldLength::banner = 6;
-const size_t DBFieldLength::city = 100;
-const size_t DBFieldLength::color = 16;
-const size_t DBFieldLength::continentCode = 3;
-const size_t DBFieldLength::continentName = 15;
-const size_t DBFieldLength::countryCode = 3;
-const size_t DBFieldLength::countryName = 32;
-const size_t DBFieldLength::label = 26;
-const size_t DBFieldLength::regionCode = 8;
-const size_t DBFieldLength::regionName = 48;
-const size_t DBFieldLength::regiontype = 32;
-const size_t DBFieldLength::root = 32;
-const size_t DBFieldLength::route = 16;
-const size_t DBFieldLength::systemFullName = 60;
-const size_t DBFieldLength::systemName = 10;
-const size_t DBFieldLength::traveler = 48;
+const size_t DBFieldLength::abbrev;
+const size_t DBFieldLength::banner;
+const size_t DBFieldLength::city;
+const size_t DBFieldLength::color;
+const size_t DBFieldLength::continentCode;
+const size_t DBFieldLength::continentName;
+const size_t DBFieldLength::countryCode;
+const size_t DBFieldLength::countryName;
+const size_t DBFieldLength::label;
+const size_t DBFieldLength::regionCode;
+const size_t DBFieldLength::regionName;
+const size_t DBFieldLength::regiontype;
+const size_t DBFieldLength::root;
+const size_t DBFieldLength::route;
+const size_t DBFieldLength::systemFullName;
+const size_t DBFieldLength::systemName;
+const size_t DBFieldLength::traveler;
 // sums of other constants
-const size_t DBFieldLength::dcErrValue = DBFieldLength::root + DBFieldLength::label + 1;;
+const size_t DBFieldLength::dcErrValue;
@@ -3,23 +3,23 @@
 class DBFieldLength
 {	public:
 	// constants
-	static const size_t abbrev;
-	static const size_t banner;
-	static const size_t city;
-	static const size_t color;
-	static const size_t continentCode;
-	static const size_t continentName;
-	static const size_t countryCode;
-	static const size_t countryName;
-	static const size_t label;
-	static const size_t regionCode;
-	static const size_t regionName;
-	static const size_t regiontype;
-	static const size_t root;
-	static const size_t route;
-	static const size_t systemFullName;
-	static const size_t systemName;
-	static const size_t traveler;
+	static const size_t abbrev = 3;
+	static const size_t banner = 6;
+	static const size_t city = 100;
+	static const size_t color = 16;
+	static const size_t continentCode = 3;
+	static const size_t continentName = 15;
+	static const size_t countryCode = 3;
+	static const size_t countryName = 32;
+	static const size_t label = 26;
+	static const size_t regionCode = 8;
+	static const size_t regionName = 48;
+	static const size_t regiontype = 32;
+	static const size_t root = 32;
+	static const size_t route = 16;
+	static const size_t systemFullName = 60;
+	static const size_t systemName = 10;
+	static const size_t traveler = 48;
 	// sums of other constants
-	static const size_t dcErrValue;
+	static const size_t dcErrValue = root + label + 1;
 };
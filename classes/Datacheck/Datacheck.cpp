@@ -1,20 +1,161 @@
 #include "Datacheck.h"
+#include "../Arena/Arena.h"
+#include "../Metrics/Metrics.h"
+#include "../Route/Route.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 
 std::mutex Datacheck::mtx;
-std::list<Datacheck> Datacheck::errors;
+thread_local std::vector<Datacheck> *Datacheck::buffer = 0;
+std::vector<std::vector<Datacheck>*> Datacheck::buffers;
+std::vector<Datacheck> Datacheck::errors;
+std::vector<size_t> Datacheck::bounds;
+std::vector<size_t> Datacheck::offsets;
+size_t Datacheck::parts = 0;
+const char* Datacheck::codes[] =
+{	"ABBREV_AS_CHOP_BANNER", "ABBREV_AS_CON_BANNER", "BAD_ANGLE", "BUS_WITH_I",
+	"CON_BANNER_MISMATCH", "CON_ROUTE_MISMATCH", "DISCONNECTED_ROUTE", "DUPLICATE_COORDS",
+	"DUPLICATE_LABEL", "HIDDEN_JUNCTION", "HIDDEN_TERMINUS", "INTERSTATE_NO_HYPHEN",
+	"INVALID_FINAL_CHAR", "INVALID_FIRST_CHAR", "LABEL_INVALID_CHAR", "LABEL_LOOKS_HIDDEN",
+	"LABEL_PARENS", "LABEL_SELFREF", "LABEL_SLASHES", "LABEL_TOO_LONG",
+	"LABEL_UNDERSCORES", "LACKS_GENERIC", "LONG_SEGMENT", "LONG_UNDERSCORE",
+	"MALFORMED_LAT", "MALFORMED_LON", "MALFORMED_URL", "NONTERMINAL_UNDERSCORE",
+	"OUT_OF_BOUNDS", "SHARP_ANGLE", "US_LETTER", "VISIBLE_DISTANCE",
+	"VISIBLE_HIDDEN_COLOC"
+};
 
-void Datacheck::add(Route *rte, std::string l1, std::string l2, std::string l3, std::string c, std::string i)
-{	mtx.lock();
-	errors.emplace_back(rte, l1, l2, l3, c, i);
-	mtx.unlock();
+void Datacheck::add(Route *rte, const char *l1, const char *l2, const char *l3, Code c, const char *i)
+{	thread_buffer().emplace_back(rte, l1, l2, l3, c, i);
+	Metrics::count(Metrics::DATACHECKS, 1);
 }
 
-Datacheck::Datacheck(Route *rte, std::string l1, std::string l2, std::string l3, std::string c, std::string i)
+std::vector<Datacheck>& Datacheck::thread_buffer()
+{	// lock only the first time this thread needs its buffer
+	if (!buffer)
+	{	buffer = new std::vector<Datacheck>;
+		mtx.lock();
+		buffers.push_back(buffer);
+		mtx.unlock();
+	}
+	return *buffer;
+}
+
+const char* Datacheck::intern(const std::string &label)
+{	// copy a label that won't outlive its Waypoint
+	char *copy = (char*)Arena::allocate(label.size()+1);
+	memcpy(copy, label.data(), label.size()+1);
+	return copy;
+}
+
+Datacheck::Datacheck(Route *rte, const char *l1, const char *l2, const char *l3, Code c, const char *i)
 {	route = rte;
 	label1 = l1;
 	label2 = l2;
 	label3 = l3;
 	code = c;
-	info = i;
+	strncpy(info, i, sizeof(info)-1);
+	info[sizeof(info)-1] = 0;
 	fp = 0;
 }
+
+bool Datacheck::operator < (const Datacheck &other) const
+{	// sort by route index, then labels, then code & info
+	if (route->index != other.route->index) return route->index < other.route->index;
+	if (int cmp = strcmp(label1, other.label1)) return cmp < 0;
+	if (int cmp = strcmp(label2, other.label2)) return cmp < 0;
+	if (int cmp = strcmp(label3, other.label3)) return cmp < 0;
+	if (code != other.code) return code < other.code;
+	return strcmp(info, other.info) < 0;
+}
+
+static size_t before(std::vector<Datacheck> &b, unsigned int index)
+{	// how many of sorted buffer b's Datachecks are for Routes before index
+	return std::lower_bound(b.begin(), b.end(), index,
+				[](const Datacheck &d, unsigned int i){return d.route->index < i;}) - b.begin();
+}
+
+void Datacheck::sort_buffer(size_t b)
+{	std::sort(buffers[b]->begin(), buffers[b]->end());
+}
+
+void Datacheck::partition(size_t numparts)
+{	/* Once every buffer is sorted, make errors one more buffer, then
+	split them all into numparts parts of about the same size, each
+	starting at a Route boundary, and size errors to hold the lot. */
+	if (errors.size())
+	{	buffers.push_back(new std::vector<Datacheck>);
+		buffers.back()->swap(errors);
+	}
+	const size_t nb = buffers.size();
+	size_t total = 0;
+	unsigned int end = 0;	// one past the highest Route index in any buffer
+	for (std::vector<Datacheck> *b : buffers)
+	  if (b->size())
+	  {	total += b->size();
+		end = std::max(end, b->back().route->index+1);
+	  }
+	parts = numparts;
+	bounds.assign((parts+1)*nb, 0);
+	offsets.assign(parts+1, 0);
+	unsigned int lo = 0;
+	for (size_t p = 1; p <= parts; p++)
+	{	// the lowest Route index with at least p/parts of the total before it
+		unsigned int hi = end;
+		size_t target = total * p / parts;
+		while (lo < hi)
+		{	unsigned int mid = lo + (hi-lo)/2;
+			size_t count = 0;
+			for (std::vector<Datacheck> *b : buffers) count += before(*b, mid);
+			if (count < target) lo = mid+1;
+			else hi = mid;
+		}
+		for (size_t b = 0; b < nb; b++)
+			offsets[p] += bounds[p*nb+b] = before(*buffers[b], lo);
+	}
+	errors.resize(total);
+}
+
+void Datacheck::merge_part(size_t p)
+{	/* merge part p of every buffer into its place in errors */
+	typedef std::pair<Datacheck*, Datacheck*> Run;
+	std::vector<Run> heap;
+	const size_t nb = buffers.size();
+	for (size_t b = 0; b < nb; b++)
+	  if (bounds[p*nb+b] < bounds[(p+1)*nb+b])
+		heap.emplace_back(buffers[b]->data() + bounds[p*nb+b], buffers[b]->data() + bounds[(p+1)*nb+b]);
+	auto later = [](const Run &a, const Run &b){return *b.first < *a.first;};
+	std::make_heap(heap.begin(), heap.end(), later);
+	Datacheck *out = errors.data() + offsets[p];
+	while (heap.size())
+	{	std::pop_heap(heap.begin(), heap.end(), later);
+		Run &r = heap.back();
+		*out++ = *r.first++;
+		if (r.first == r.second) heap.pop_back();
+		else std::push_heap(heap.begin(), heap.end(), later);
+	}
+}
+
+void Datacheck::collect()
+{	/* Once every part has been merged into errors, free the buffers.
+	Must be called by the thread that will go on adding Datachecks,
+	once all others are done. */
+	for (std::vector<Datacheck> *b : buffers) delete b;
+	buffers.clear();
+	bounds.clear();
+	offsets.clear();
+	parts = 0;
+	buffer = 0;
+}
+
+bool Datacheck::write(std::string filename)
+{	/* write errors to filename, one per line, in their canonical order,
+	so the log from any thread count can be diffed against any other */
+	FILE *f = fopen(filename.data(), "w");
+	if (!f) return 0;
+	for (Datacheck &d : errors)
+		fprintf(f, "%s;%s;%s;%s;%s;%s\n", d.route->root.data(),
+			d.label1, d.label2, d.label3, codes[d.code], d.info);
+	return !fclose(f);
+}
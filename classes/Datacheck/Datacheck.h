@@ -1,18 +1,23 @@
 class Route;
-#include <list>
+#include "../DBFieldLength/DBFieldLength.h"
 #include <mutex>
+#include <string>
+#include <vector>
 
 class Datacheck
 {   /* This class encapsulates a datacheck log entry
 
     route is a pointer to the route with a datacheck error
 
-    label1, label2 & label3 are labels that are related to the error
+    label1, label2 & label3 point to labels that are related to the error
     (such as the endpoints of a too-long segment or the three points
-    that form a sharp angle)
+    that form a sharp angle). They are not copied, so must outlive the
+    Datacheck; Waypoints' labels do, staying in the Arena or a Snapshot
+    mapping even if the Waypoint is deleted. Other strings are first
+    copied into the Arena with intern.
 
     code is the error code | info is additional
-    string, one of:        | information, if used:
+    enum, one of:          | information, if used:
     -----------------------+--------------------------------------------
     ABBREV_AS_CHOP_BANNER  | offending line # in chopped route CSV
     ABBREV_AS_CON_BANNER   | offending line # in connected route CSV
@@ -48,22 +53,61 @@ class Datacheck
     VISIBLE_DISTANCE       | distance in miles
     VISIBLE_HIDDEN_COLOC   | hidden point at same coordinates
 
+    info is copied into the Datacheck itself; it's truncated to fit the
+    DB's info column, as it would have been when inserted anyway.
+
     fp is a boolean indicating whether this has been reported as a
     false positive (would be set to true later)
 
+    Each thread adds Datachecks to its own buffer, without locking.
+    After a multi-threaded phase, each buffer is sorted on its own
+    (DatacheckSortThread), then partition splits the lot into ranges
+    of whole Routes, one per merge task, and sizes errors to hold them.
+    Each task merges its range from every buffer straight into its own
+    stretch of errors (DatacheckMergeThread), so no merge is serial.
+    The stable key is the Route's index (its position in system & route
+    order), then labels, code & info; errors is thus always in the same
+    order no matter how many threads ran, or which did what.
     */
-	static std::mutex mtx;
+	static std::mutex mtx;		// for locking the buffers list when a thread creates its buffer
+	static thread_local std::vector<Datacheck> *buffer;
+	static std::vector<size_t> bounds;	// [part*buffers + buffer]: where each part begins in each buffer
+	static std::vector<size_t> offsets;	// [part]: where each part begins in errors
 	public:
+	enum Code : unsigned char
+	{	ABBREV_AS_CHOP_BANNER, ABBREV_AS_CON_BANNER, BAD_ANGLE, BUS_WITH_I,
+		CON_BANNER_MISMATCH, CON_ROUTE_MISMATCH, DISCONNECTED_ROUTE, DUPLICATE_COORDS,
+		DUPLICATE_LABEL, HIDDEN_JUNCTION, HIDDEN_TERMINUS, INTERSTATE_NO_HYPHEN,
+		INVALID_FINAL_CHAR, INVALID_FIRST_CHAR, LABEL_INVALID_CHAR, LABEL_LOOKS_HIDDEN,
+		LABEL_PARENS, LABEL_SELFREF, LABEL_SLASHES, LABEL_TOO_LONG,
+		LABEL_UNDERSCORES, LACKS_GENERIC, LONG_SEGMENT, LONG_UNDERSCORE,
+		MALFORMED_LAT, MALFORMED_LON, MALFORMED_URL, NONTERMINAL_UNDERSCORE,
+		OUT_OF_BOUNDS, SHARP_ANGLE, US_LETTER, VISIBLE_DISTANCE,
+		VISIBLE_HIDDEN_COLOC
+	};
+	static const char* codes[];	// names of the above, in the same (alphabetical) order
+
 	Route *route;
-	std::string label1;
-	std::string label2;
-	std::string label3;
-	std::string code;
-	std::string info;
+	const char *label1;
+	const char *label2;
+	const char *label3;
+	Code code;
 	bool fp;
+	char info[DBFieldLength::dcErrValue+1];
 
-	static std::list<Datacheck> errors;
-	static void add(Route*, std::string, std::string, std::string, std::string, std::string);
+	static std::vector<std::vector<Datacheck>*> buffers;
+	static std::vector<Datacheck> errors;
+	static void add(Route*, const char*, const char*, const char*, Code, const char*);
+	static std::vector<Datacheck>& thread_buffer();
+	static const char* intern(const std::string&);
+	static size_t parts;
+	static void sort_buffer(size_t);
+	static void partition(size_t);
+	static void merge_part(size_t);
+	static void collect();
+	static bool write(std::string);
 
-	Datacheck(Route*, std::string, std::string, std::string, std::string, std::string);
+	Datacheck() {}
+	Datacheck(Route*, const char*, const char*, const char*, Code, const char*);
+	bool operator < (const Datacheck &) const;
 };
@@ -7,9 +7,12 @@ ElapsedTime::ElapsedTime(int precision)
 	str = new char[15+precision];
 }
 
-std::string ElapsedTime::et()
+double ElapsedTime::seconds()
 {	using namespace std::chrono;
-	duration<double> elapsed = duration_cast<duration<double>>(steady_clock::now() - start_time);
-	sprintf(str, format.data(), elapsed.count());
+	return duration_cast<duration<double>>(steady_clock::now() - start_time).count();
+}
+
+std::string ElapsedTime::et()
+{	sprintf(str, format.data(), seconds());
 	return str;
 }
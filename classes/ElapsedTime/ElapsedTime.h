@@ -9,5 +9,6 @@ class ElapsedTime
 
 	public:
 	ElapsedTime(int);
+	double seconds();
 	std::string et();
 };
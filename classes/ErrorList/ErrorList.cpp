@@ -1,8 +1,67 @@
 #include "ErrorList.h"
+#include "../Metrics/Metrics.h"
+#include <algorithm>
 
-void ErrorList::add_error(std::string e)
-{	mtx.lock();
-	std::cout << "ERROR: " << e << std::endl;
-	error_list.push_back(e);
+std::atomic<uint64_t> ErrorList::next_id(0);
+thread_local uint64_t ErrorList::order = 0;
+
+ErrorList::ErrorList()
+{	quiet = 0;
+	id = next_id++;
+}
+
+ErrorList::~ErrorList()
+{	for (Buffer *b : buffers) delete b;
+}
+
+std::vector<ErrorList::Error>& ErrorList::thread_buffer()
+{	// this thread's buffer, found or created under the mutex only
+	// when it's not the one this thread used last
+	static thread_local uint64_t last_id = -1;
+	static thread_local std::vector<Error> *last = 0;
+	if (last_id == id) return *last;
+	std::thread::id self = std::this_thread::get_id();
+	mtx.lock();
+	Buffer *buf = 0;
+	for (Buffer *b : buffers)
+	  if (b->thread == self)
+	  {	buf = b;
+		break;
+	  }
+	if (!buf)
+	{	buf = new Buffer;
+		buf->thread = self;
+		buffers.push_back(buf);
+	}
 	mtx.unlock();
+	last_id = id;
+	last = &buf->errors;
+	return *last;
+}
+
+void ErrorList::add_error(std::string e)
+{	if (quiet) error_list.push_back(std::move(e));
+	else {	thread_buffer().push_back(Error{order, std::move(e)});
+		Metrics::count(Metrics::ERRORS, 1);
+	     }
+}
+
+void ErrorList::flush()
+{	/* merge every thread's buffered errors into error_list, by order,
+	& print them. Not safe while other threads are adding errors. */
+	std::vector<Error> batch;
+	for (Buffer *b : buffers)
+	{	for (Error &e : b->errors) batch.push_back(std::move(e));
+		b->errors.clear();
+	}
+	if (batch.empty()) return;
+	std::stable_sort(batch.begin(), batch.end(), [](const Error &a, const Error &b){return a.order < b.order;});
+	std::string out;
+	for (Error &e : batch)
+	{	out += "ERROR: ";
+		out += e.text;
+		out += '\n';
+		error_list.push_back(std::move(e.text));
+	}
+	std::cout << out << std::flush;
 }
@@ -1,11 +1,51 @@
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 class ErrorList
-{	/* Track a list of potentially fatal errors */
-	std::mutex mtx;
+{	/* Track a list of potentially fatal errors.
+
+	add_error never blocks or prints: each thread appends to its own
+	buffer, registered under the mutex on its first error. flush,
+	called by the main thread between phases, moves the buffered
+	errors into error_list and prints them in one batch.
+
+	Errors are merged by the value of order when they were added. In
+	a parallel phase, set it to the position of each unit of work
+	(such as a Route's index) so error_list reads as it would have had
+	everything run serially; errors with the same order stay in the
+	order they were added.
+
+	A quiet ErrorList belongs to one thread, and stores errors straight
+	into error_list without printing them, so they can be reported
+	later, in order, through another one.
+	*/
+	struct Error
+	{	uint64_t order;
+		std::string text;
+	};
+	struct Buffer
+	{	std::thread::id thread;
+		std::vector<Error> errors;
+	};
+	std::mutex mtx;			// for locking the buffers list when a thread creates its buffer
+	std::vector<Buffer*> buffers;
+	uint64_t id;			// tells this ErrorList from any since deleted at the same address
+	static std::atomic<uint64_t> next_id;
+
+	std::vector<Error>& thread_buffer();
+
 	public:
 	std::vector<std::string> error_list;
+	bool quiet;
+	static thread_local uint64_t order;
+
+	ErrorList();
+	~ErrorList();
 	void add_error(std::string);
+	void flush();
 };
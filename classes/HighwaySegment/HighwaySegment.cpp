@@ -1,13 +1,21 @@
 #include "HighwaySegment.h"
-#include "../Waypoint/Waypoint.h"
+#include "../Arena/Arena.h"
 
-HighwaySegment::HighwaySegment(Waypoint *w1, Waypoint *w2, Route *rte)
+HighwaySegment::HighwaySegment(Waypoint *w1, Waypoint *w2, Route *rte, double len)
 {	waypoint1 = w1;
 	waypoint2 = w2;
 	route = rte;
-	length = waypoint1->distance_to(waypoint2);
+	length = len;
 	concurrent = 0;
 	system_concurrency_count = 1;
 	active_only_concurrency_count = 1;
 	active_preview_concurrency_count = 1;
 }
+
+void* HighwaySegment::operator new(size_t size)
+{	return Arena::allocate(size);
+}
+
+void HighwaySegment::operator delete(void* p, size_t size)
+{	Arena::deallocate(p, size);
+}
@@ -3,7 +3,7 @@ class TravelerList;
 class Waypoint;
 #include <list>
 #include <mutex>
-#include <unordered_set>
+#include <vector>
 
 class HighwaySegment
 {   /* This class represents one highway segment: the connection between two
@@ -15,11 +15,13 @@ class HighwaySegment
 	Route *route;
 	double length;
 	std::list<HighwaySegment*> *concurrent;
-	std::unordered_set<TravelerList*> clinched_by;
+	std::vector<TravelerList*> clinched_by;	// each traveler once, in no set order
 	std::mutex clin_mtx;
 	unsigned char system_concurrency_count;
 	unsigned char active_only_concurrency_count;
 	unsigned char active_preview_concurrency_count;
 
-	HighwaySegment(Waypoint *, Waypoint *, Route *);
+	HighwaySegment(Waypoint *, Waypoint *, Route *, double);
+	static void* operator new(size_t);		// allocated from the calling thread's Arena
+	static void operator delete(void*, size_t);	// reclaimed only if it was the Arena's last allocation
 };
@@ -1,4 +1,5 @@
 #include "HighwaySystem.h"
+#include "../Arena/Arena.h"
 #include "../Args/Args.h"
 #include "../ConnectedRoute/ConnectedRoute.h"
 #include "../DBFieldLength/DBFieldLength.h"
@@ -10,18 +11,18 @@
 #include <fstream>
 
 std::list<HighwaySystem*> HighwaySystem::syslist;
-std::list<HighwaySystem*>::iterator HighwaySystem::it;
-std::vector<HighwaySystem*> HighwaySystem::in_flight;
 
-HighwaySystem::HighwaySystem(std::string &line, ErrorList &el, std::vector<std::pair<std::string,std::string>> &countries)
+HighwaySystem::HighwaySystem(std::string &line, std::vector<std::pair<std::string,std::string>> &countries)
 {	std::ifstream file;
+	errors = new ErrorList;
+	errors->quiet = 1;
 	// parse systems.csv line
 	size_t NumFields = 6;
 	std::string country_str, tier_str, level_str;
 	std::string* fields[6] = {&systemname, &country_str, &fullname, &color, &tier_str, &level_str};
 	split(line, fields, NumFields, ';');
 	if (NumFields != 6)
-	{	el.add_error("Could not parse " + Args::systemsfile
+	{	errors->add_error("Could not parse " + Args::systemsfile
 			   + " line: [" + line + "], expected 6 fields, found " + std::to_string(NumFields));
 		is_valid = 0;
 		return;
@@ -29,46 +30,49 @@ HighwaySystem::HighwaySystem(std::string &line, ErrorList &el, std::vector<std::
 	is_valid = 1;
 	// System
 	if (systemname.size() > DBFieldLength::systemName)
-		el.add_error("System code > " + std::to_string(DBFieldLength::systemName)
+		errors->add_error("System code > " + std::to_string(DBFieldLength::systemName)
 			   + " bytes in " + Args::systemsfile + " line " + line);
 	// CountryCode
 	country = country_or_continent_by_code(country_str, countries);
 	if (!country)
-	{	el.add_error("Could not find country matching " + Args::systemsfile + " line: " + line);
+	{	errors->add_error("Could not find country matching " + Args::systemsfile + " line: " + line);
 		country = country_or_continent_by_code("error", countries);
 	}
 	// Name
 	if (fullname.size() > DBFieldLength::systemFullName)
-		el.add_error("System name > " + std::to_string(DBFieldLength::systemFullName)
+		errors->add_error("System name > " + std::to_string(DBFieldLength::systemFullName)
 			   + " bytes in " + Args::systemsfile + " line " + line);
 	// Color
 	if (color.size() > DBFieldLength::color)
-		el.add_error("Color > " + std::to_string(DBFieldLength::color)
+		errors->add_error("Color > " + std::to_string(DBFieldLength::color)
 			   + " bytes in " + Args::systemsfile + " line " + line);
 	// Tier
 	char *endptr;
 	tier = strtol(tier_str.data(), &endptr, 10);
 	if (*endptr || tier < 1)
-		el.add_error("Invalid tier in " + Args::systemsfile + " line " + line);
+		errors->add_error("Invalid tier in " + Args::systemsfile + " line " + line);
 	// Level
 	level = level_str[0];
 	if (level_str != "active" && level_str != "preview" && level_str != "devel")
-		el.add_error("Unrecognized level in " + Args::systemsfile + " line: " + line);
+		errors->add_error("Unrecognized level in " + Args::systemsfile + " line: " + line);
 
-	std::cout << systemname << '.' << std::flush;
+	error_marks.push_back(errors->error_list.size());
 
 	// read chopped routes CSV
 	file.open(Args::highwaydatapath+"/hwy_data/_systems"+"/"+systemname+".csv");
-	if (!file) el.add_error("Could not open "+Args::highwaydatapath+"/hwy_data/_systems"+"/"+systemname+".csv");
+	if (!file) errors->add_error("Could not open "+Args::highwaydatapath+"/hwy_data/_systems"+"/"+systemname+".csv");
 	else {	getline(file, line); // ignore header line
 		while(getline(file, line))
 		{	if (line.empty()) continue;
 			// trim DOS newlines & trailing whitespace
 			while ( strchr("\r\t ", line.back()) ) line.pop_back();
-			Route* r = new Route(line, this, el);
+			Route* r = new Route(line, this, *errors);
 				   // deleted on termination of program
-			if (r->root.size()) route_list.push_back(r);
-			else {	el.add_error("Unable to find root in " + systemname +".csv line: ["+line+"]");
+			if (r->root.size())
+			{	route_list.push_back(r);
+				error_marks.push_back(errors->error_list.size());
+			}
+			else {	errors->add_error("Unable to find root in " + systemname +".csv line: ["+line+"]");
 				delete r;
 			     }
 		}
@@ -77,20 +81,60 @@ HighwaySystem::HighwaySystem(std::string &line, ErrorList &el, std::vector<std::
 
 	// read connected routes CSV
 	file.open(Args::highwaydatapath+"/hwy_data/_systems"+"/"+systemname+"_con.csv");
-	if (!file) el.add_error("Could not open "+Args::highwaydatapath+"/hwy_data/_systems"+"/"+systemname+"_con.csv");
+	if (!file) errors->add_error("Could not open "+Args::highwaydatapath+"/hwy_data/_systems"+"/"+systemname+"_con.csv");
 	else {	getline(file, line); // ignore header line
 		while(getline(file, line))
 		{	if (line.empty()) continue;
 			// trim DOS newlines & trailing whitespace
 			while ( strchr("\r\t ", line.back()) ) line.pop_back();
-			con_route_list.push_back(new ConnectedRoute(line, this, el));
+			con_route_list.push_back(new ConnectedRoute(line, this, *errors));
 						 // deleted on termination of program
+			error_marks.push_back(errors->error_list.size());
 		}
 	     }
 	file.close();
 }
 
+void HighwaySystem::insert_routes(ErrorList &el)
+{	/* the part of construction that has to wait for the systems
+	before this one, with the constructor's errors reported as
+	they'd have been found if it had all been done in order */
+	size_t e = 0;
+	auto report_to = [&](size_t mark)
+	{	for (; e < mark; e++) el.add_error(errors->error_list[e]);
+	};
+	std::vector<size_t>::iterator mark = error_marks.begin();
+	if (is_valid)
+	{	report_to(*mark++);
+		std::cout << systemname << '.' << std::flush;
+		for (Route *r : route_list)
+		{	report_to(*mark++);
+			r->insert_names(el);
+		}
+		for (ConnectedRoute *cr : con_route_list)
+		{	report_to(*mark++);
+			cr->find_roots(el);
+		}
+	}
+	report_to(errors->error_list.size());
+	delete errors;
+	errors = 0;
+	std::vector<size_t>().swap(error_marks);
+}
+
 /* Return whether this is an active system */
 bool HighwaySystem::active()
 {	return level == 'a';
 }
+
+bool HighwaySystem::active_or_preview()
+{	return level == 'a' || level == 'p';
+}
+
+void* HighwaySystem::operator new(size_t size)
+{	return Arena::allocate(size);
+}
+
+void HighwaySystem::operator delete(void* p, size_t size)
+{	Arena::deallocate(p, size);
+}
@@ -24,6 +24,13 @@ class HighwaySystem
 	In most cases, the connected route is just a single Route, but when
 	a designation within the same system crosses region boundaries,
 	a connected route defines the entirety of the route.
+
+	Systems are constructed in parallel, so anything that depends on
+	the systems before this one waits for insert_routes, called for
+	each system in systems.csv order: checking for duplicate root &
+	list names, and finding connected routes' roots. The constructor's
+	errors wait too, and are reported in between, in .csv order, so
+	the error list reads exactly as if everything ran serially.
 	*/
 
 	public:
@@ -41,12 +48,16 @@ class HighwaySystem
 	std::unordered_set<std::string>listnamesinuse, unusedaltroutenames;
 	std::mutex lniu_mtx, uarn_mtx;
 	bool is_valid;
+	ErrorList *errors;			// constructor's errors, until insert_routes
+	std::vector<size_t> error_marks;	// errors.size() after the systems.csv line, then after each Route & ConnectedRoute
 
 	static std::list<HighwaySystem*> syslist;
-	static std::list<HighwaySystem*>::iterator it;
-	static std::vector<HighwaySystem*> in_flight;
 
-	HighwaySystem(std::string &, ErrorList &, std::vector<std::pair<std::string,std::string>> &);
+	HighwaySystem(std::string &, std::vector<std::pair<std::string,std::string>> &);
+	static void* operator new(size_t);		// allocated from the calling thread's Arena
+	static void operator delete(void*, size_t);	// reclaimed only if it was the Arena's last allocation
 
+	void insert_routes(ErrorList &);
 	bool active();			// Return whether this is an active system
+	bool active_or_preview();	// Return whether this is an active or preview system
 };
@@ -0,0 +1,137 @@
+#include "Metrics.h"
+#include "../ElapsedTime/ElapsedTime.h"
+#include <ctime>
+#include <sys/resource.h>
+
+ElapsedTime *Metrics::et = 0;
+std::vector<Metrics::Phase*> Metrics::phases;
+Metrics::Phase *Metrics::current = 0;
+std::vector<Metrics::Counts*> Metrics::counts;
+thread_local Metrics::Counts *Metrics::mine = 0;
+std::mutex Metrics::mtx;
+
+static const char *counter_names[] = {"bytes", "files", "routes", "waypoints", "segments", "datachecks", "errors"};
+
+double Metrics::cpu_seconds()
+{	// CPU time used by the calling thread
+	timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+void Metrics::totals(size_t *n)
+{	for (size_t c = 0; c < NUM_COUNTERS; c++) n[c] = 0;
+	mtx.lock();
+	for (Counts *t : counts)
+	  for (size_t c = 0; c < NUM_COUNTERS; c++) n[c] += t->n[c];
+	mtx.unlock();
+}
+
+void Metrics::start(ElapsedTime *e)
+{	et = e;
+}
+
+void Metrics::phase(const char *name)
+{	/* end every open phase, and start a new top-level one */
+	while (current) end();
+	begin(name);
+}
+
+void Metrics::begin(const char *name)
+{	/* start a phase within the current one, if any */
+	Phase *p = new Phase;
+	p->name = name;
+	p->parent = current;
+	p->start = et->seconds();
+	p->cpu = cpu_seconds();
+	totals(p->counts);
+	(current ? current->children : phases).push_back(p);
+	current = p;
+}
+
+void Metrics::end()
+{	/* end the innermost open phase */
+	if (!current) return;
+	size_t n[NUM_COUNTERS];
+	totals(n);
+	for (size_t c = 0; c < NUM_COUNTERS; c++) current->counts[c] = n[c] - current->counts[c];
+	current->wall = et->seconds() - current->start;
+	current->cpu = cpu_seconds() - current->cpu;
+	current = current->parent;
+}
+
+void Metrics::count(Counter c, size_t n)
+{	// lock only the first time this thread counts anything
+	if (!mine)
+	{	mine = new Counts();
+		mtx.lock();
+		counts.push_back(mine);
+		mtx.unlock();
+	}
+	mine->n[c] += n;
+}
+
+Metrics::ThreadTimer::ThreadTimer()
+{	start = cpu_seconds();
+}
+
+Metrics::ThreadTimer::~ThreadTimer()
+{	double cpu = cpu_seconds() - start;
+	mtx.lock();
+	if (current) current->thread_cpu.push_back(cpu);
+	mtx.unlock();
+}
+
+double Metrics::thread_cpu_total(Phase *p)
+{	// worker threads' CPU seconds, in this phase & the phases within it
+	double total = 0;
+	for (double t : p->thread_cpu) total += t;
+	for (Phase *c : p->children) total += thread_cpu_total(c);
+	return total;
+}
+
+void Metrics::write_phase(FILE *f, Phase *p, int depth)
+{	std::string indent(depth, '\t');
+	double threads = thread_cpu_total(p);
+	fprintf(f, "%s{\"name\": \"%s\", \"wall_seconds\": %.6f, \"cpu_seconds\": %.6f, \"main_cpu_seconds\": %.6f,\n",
+		indent.data(), p->name, p->wall, p->cpu + threads, p->cpu);
+	fprintf(f, "%s \"thread_cpu_seconds\": [", indent.data());
+	for (size_t t = 0; t < p->thread_cpu.size(); t++) fprintf(f, "%s%.6f", t ? ", " : "", p->thread_cpu[t]);
+	fputs("],\n", f);
+	fprintf(f, "%s \"counters\": {", indent.data());
+	for (size_t c = 0; c < NUM_COUNTERS; c++) fprintf(f, "%s\"%s\": %zu", c ? ", " : "", counter_names[c], p->counts[c]);
+	fputs("}", f);
+	if (p->children.size())
+	{	fprintf(f, ",\n%s \"phases\": [\n", indent.data());
+		for (size_t i = 0; i < p->children.size(); i++)
+		{	if (i) fputs(",\n", f);
+			write_phase(f, p->children[i], depth+1);
+		}
+		fprintf(f, "\n%s ]", indent.data());
+	}
+	fputs("}", f);
+}
+
+bool Metrics::write(std::string filename)
+{	/* end every open phase & write the report to filename */
+	while (current) end();
+	FILE *f = fopen(filename.data(), "w");
+	if (!f) return 0;
+	size_t n[NUM_COUNTERS];
+	totals(n);
+	timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	fprintf(f, "{\"wall_seconds\": %.6f, \"cpu_seconds\": %.6f, \"peak_rss_kb\": %ld,\n \"counters\": {",
+		et->seconds(), ts.tv_sec + ts.tv_nsec/1e9, ru.ru_maxrss);
+	for (size_t c = 0; c < NUM_COUNTERS; c++) fprintf(f, "%s\"%s\": %zu", c ? ", " : "", counter_names[c], n[c]);
+	fputs("},\n \"phases\": [\n", f);
+	for (size_t i = 0; i < phases.size(); i++)
+	{	if (i) fputs(",\n", f);
+		write_phase(f, phases[i], 1);
+	}
+	fputs("\n]}\n", f);
+	bool ok = !ferror(f);
+	return !fclose(f) && ok;
+}
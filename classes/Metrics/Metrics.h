@@ -0,0 +1,65 @@
+class ElapsedTime;
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Metrics
+{	/* Timing & counters for each phase of a run, written as JSON
+	to the log path at exit for dashboards to read.
+
+	The main thread marks off top-level phases with phase, and
+	sub-phases within them with begin & end. A phase's wall time
+	comes from the ElapsedTime the run's log lines are stamped with;
+	its CPU time is the main thread's, plus each worker thread's,
+	recorded by a ThreadTimer at the top of each thread function.
+
+	Counters are kept per thread, so counting takes no lock. A
+	phase's counts are the change in their totals from its start to
+	its end; they're only totalled at phase boundaries, while no
+	worker threads are running.
+	*/
+	public:
+	enum Counter { BYTES, FILES, ROUTES, WAYPOINTS, SEGMENTS, DATACHECKS, ERRORS, NUM_COUNTERS };
+
+	private:
+	struct Phase
+	{	const char *name;
+		Phase *parent;
+		double start, wall;			// seconds
+		double cpu;				// main thread's CPU seconds
+		std::vector<double> thread_cpu;		// CPU seconds of each worker thread run in this phase itself
+		size_t counts[NUM_COUNTERS];		// totals at start, then counts during
+		std::vector<Phase*> children;
+	};
+	struct Counts
+	{	size_t n[NUM_COUNTERS];
+	};
+	static ElapsedTime *et;
+	static std::vector<Phase*> phases;	// top-level
+	static Phase *current;			// innermost open phase, or 0
+	static std::vector<Counts*> counts;	// one per thread that's counted anything
+	static thread_local Counts *mine;
+	static std::mutex mtx;			// for locking counts, and current's thread_cpu
+
+	static double cpu_seconds();
+	static void totals(size_t *);
+	static double thread_cpu_total(Phase *);
+	static void write_phase(FILE *, Phase *, int);
+
+	public:
+	class ThreadTimer
+	{	double start;
+		public:
+		ThreadTimer();
+		~ThreadTimer();
+	};
+
+	static void start(ElapsedTime *);
+	static void phase(const char *);
+	static void begin(const char *);
+	static void end();
+	static void count(Counter, size_t);
+	static bool write(std::string);
+};
@@ -0,0 +1,9 @@
+#include "../Arena/Arena.h"
+#include <cstring>
+
+const char *name_copy(const char *key, size_t len)
+{	char *copy = (char*)Arena::allocate(len+1);
+	memcpy(copy, key, len);
+	copy[len] = 0;
+	return copy;
+}
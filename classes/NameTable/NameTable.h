@@ -0,0 +1,140 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+
+const char *name_copy(const char *, size_t);	// copy of a key, allocated from the calling thread's Arena
+
+template <class T, bool fold_case> class NameTable
+{	/* A hash table of T*, keyed by name, for the lookups done
+	millions of times per run.
+
+	Open addressing with linear probing, so a lookup walks one
+	contiguous run of slots and allocates nothing. Keys are given as
+	pointer & length, so any piece of a longer string can be looked
+	up without copying it out first. With fold_case, ASCII letters
+	match regardless of case.
+
+	find & insert can be called from any number of threads at once,
+	provided reserve made room for every entry beforehand. A slot is
+	claimed by setting its hash; its key is stored next, and its value
+	last, marking it ready. Anyone probing a claimed slot with the same
+	hash waits for that before comparing keys. A miss is reported by
+	returning 0. Keys are copied into the Arena on insertion, and
+	entries are never removed.
+	*/
+	struct Slot
+	{	std::atomic<uint64_t> hash;	// 0 if empty
+		std::atomic<T*> value;		// 0 until key & len are stored
+		const char *key;
+		size_t len;
+	};
+	Slot *slots;
+	size_t capacity;		// always a power of 2, or 0
+	std::atomic<size_t> count;
+
+	static unsigned char fold(unsigned char c)
+	{	return fold_case && c >= 'a' && c <= 'z' ? c-32 : c;
+	}
+
+	static uint64_t hash(const char *key, size_t len)
+	{	uint64_t h = 0xCBF29CE484222325ULL;	// FNV-1a
+		for (size_t i = 0; i < len; i++)
+			h = (h ^ fold(key[i])) * 0x100000001B3ULL;
+		return h | 1;	// 0 marks an empty slot
+	}
+
+	static bool same_key(Slot &s, const char *key, size_t len)
+	{	if (s.len != len) return 0;
+		for (size_t i = 0; i < len; i++)
+		  if (fold(s.key[i]) != fold(key[i])) return 0;
+		return 1;
+	}
+
+	static T* ready(Slot &s)
+	{	// wait for a just-claimed slot's key & value to be stored
+		T* value;
+		while (!(value = s.value.load(std::memory_order_acquire)))
+			std::this_thread::yield();
+		return value;
+	}
+
+	public:
+	NameTable()
+	{	slots = 0;
+		capacity = 0;
+		count = 0;
+	}
+
+	~NameTable()
+	{	delete[] slots;
+	}
+
+	void reserve(size_t n)
+	{	/* make room for n entries at a load factor of at most 1/2.
+		Not safe while other threads are using the table. */
+		size_t cap = 16;
+		while (cap < 2*n) cap *= 2;
+		if (cap <= capacity) return;
+		Slot *old = slots;
+		size_t old_cap = capacity;
+		slots = new Slot[cap]();
+		capacity = cap;
+		for (size_t o = 0; o < old_cap; o++)
+		  if (uint64_t h = old[o].hash.load(std::memory_order_relaxed))
+		  {	size_t i = h & (capacity-1);
+			while (slots[i].hash.load(std::memory_order_relaxed)) i = (i+1) & (capacity-1);
+			slots[i].hash.store(h, std::memory_order_relaxed);
+			slots[i].key = old[o].key;
+			slots[i].len = old[o].len;
+			slots[i].value.store(old[o].value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		  }
+		delete[] old;
+	}
+
+	size_t size()
+	{	return count;
+	}
+
+	T* find(const char *key, size_t len)
+	{	/* return key's value, or 0 if it isn't in the table */
+		if (!capacity) return 0;
+		uint64_t h = hash(key, len);
+		for (size_t i = h & (capacity-1);; i = (i+1) & (capacity-1))
+		{	uint64_t sh = slots[i].hash.load(std::memory_order_acquire);
+			if (!sh) return 0;
+			if (sh == h)
+			{	T* value = ready(slots[i]);
+				if (same_key(slots[i], key, len)) return value;
+			}
+		}
+	}
+	T* find(const char *key)		{return find(key, strlen(key));}
+	T* find(const std::string &key)		{return find(key.data(), key.size());}
+
+	T* insert(const char *key, size_t len, T* value)
+	{	/* add key with value, unless key is already in the table;
+		return 0 if it was added, else the value it already had.
+		If nothing reserved room for it, the table grows, which is
+		only safe if no other thread is using it. */
+		if (2*(count+1) > capacity) reserve(count+1);
+		uint64_t h = hash(key, len);
+		for (size_t i = h & (capacity-1);; i = (i+1) & (capacity-1))
+		{	uint64_t sh = slots[i].hash.load(std::memory_order_acquire);
+			if (!sh && slots[i].hash.compare_exchange_strong(sh, h, std::memory_order_acq_rel))
+			{	slots[i].key = name_copy(key, len);
+				slots[i].len = len;
+				slots[i].value.store(value, std::memory_order_release);
+				count++;
+				return 0;
+			}
+			// sh now holds whatever hash the slot has, even if another thread just claimed it
+			if (sh == h)
+			{	T* existing = ready(slots[i]);
+				if (same_key(slots[i], key, len)) return existing;
+			}
+		}
+	}
+	T* insert(const std::string &key, T* value)	{return insert(key.data(), key.size(), value);}
+};
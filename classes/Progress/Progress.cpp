@@ -0,0 +1,111 @@
+#include "Progress.h"
+#include "../HighwaySystem/HighwaySystem.h"
+#include "../Route/Route.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+Progress::Slot *Progress::slots = 0;
+unsigned int Progress::numslots = 0;
+size_t Progress::total = 0;
+unsigned short Progress::width = 80;
+std::chrono::steady_clock::time_point Progress::start_time, Progress::last_draw;
+std::mutex Progress::mtx;
+std::condition_variable Progress::cv;
+bool Progress::running = 0;
+const std::chrono::milliseconds Progress::interval(250);
+bool Progress::enabled = 0;
+
+bool Progress::start(size_t routes, unsigned int numthreads)
+{	/* get ready to track routes Routes read by numthreads threads;
+	return whether there's a terminal to draw progress on */
+	// new doesn't honor alignas(64) before C++17, so allocate aligned by hand
+	free(slots);
+	void *p;
+	if (posix_memalign(&p, alignof(Slot), numthreads*sizeof(Slot))) throw std::bad_alloc();
+	slots = (Slot*)p;
+	for (unsigned int t = 0; t < numthreads; t++) new (slots+t) Slot();
+	numslots = numthreads;
+	total = routes;
+	start_time = last_draw = std::chrono::steady_clock::now();
+	running = 1;
+	struct winsize ws;
+	enabled = isatty(STDOUT_FILENO);
+	if (enabled && !ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) && ws.ws_col) width = ws.ws_col;
+	return enabled;
+}
+
+inline void Progress::add(std::atomic<size_t> &counter, size_t n)
+{	// only the slot's own thread writes it, so no read-modify-write needed
+	counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void Progress::reading(unsigned int id, Route *r)
+{	slots[id].route.store(r, std::memory_order_relaxed);
+}
+
+void Progress::read(unsigned int id, size_t bytes)
+{	add(slots[id].bytes, bytes);
+}
+
+void Progress::done(unsigned int id)
+{	add(slots[id].routes, 1);
+	slots[id].route.store(0, std::memory_order_relaxed);
+}
+
+void Progress::draw()
+{	/* redraw the progress line from the counters as they stand */
+	using namespace std::chrono;
+	last_draw = steady_clock::now();
+	double seconds = duration_cast<duration<double>>(last_draw - start_time).count();
+	size_t routes = 0, bytes = 0;
+	for (unsigned int t = 0; t < numslots; t++)
+	{	routes += slots[t].routes.load(std::memory_order_relaxed);
+		bytes  += slots[t].bytes .load(std::memory_order_relaxed);
+	}
+	char counts[96];
+	snprintf(counts, sizeof(counts), "%zu/%zu routes, %.0f routes/s, %.1f MB/s ", routes, total,
+		 seconds ? routes/seconds : 0, seconds ? bytes/seconds/1048576 : 0);
+	std::string line = counts;
+	for (unsigned int t = 0; t < numslots; t++)
+	{	Route *r = slots[t].route.load(std::memory_order_relaxed);
+		std::string name = r ? r->system->systemname : "";
+		name.resize(11, ' '); // pad to 11 chars with spaces
+		line += "| " + name;
+	}
+	line += '|';
+	if (line.size() >= width) line.resize(width-1);
+	fputs(('\r' + line + "\033[K").data(), stdout);
+	fflush(stdout);
+}
+
+void Progress::tick()
+{	/* draw if it's been at least interval since last time */
+	if (enabled && std::chrono::steady_clock::now() - last_draw >= interval) draw();
+}
+
+bool Progress::wait()
+{	/* wait one interval, or until stop is called;
+	return whether to draw again */
+	std::unique_lock<std::mutex> lock(mtx);
+	cv.wait_for(lock, interval, []{return !running;});
+	return running;
+}
+
+void Progress::stop()
+{	mtx.lock();
+	running = 0;
+	mtx.unlock();
+	cv.notify_all();
+}
+
+void Progress::finish()
+{	/* draw the final counts & end the line */
+	if (!enabled) return;
+	draw();
+	fputs("\n", stdout);
+	fflush(stdout);
+}
@@ -0,0 +1,48 @@
+class Route;
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+class Progress
+{	/* Progress of reading waypoints, redrawn in place on one line:
+	routes read, routes & megabytes per second, and each thread's
+	current system.
+
+	Each thread only ever writes its own Slot, with relaxed atomic
+	stores; nothing it does waits on the terminal or on another
+	thread. The line is drawn at a fixed rate by whoever's reporting:
+	ProgressThread in siteupdate, or tick between Routes in
+	siteupdateST. When stdout isn't a terminal, nothing's drawn.
+	*/
+	struct alignas(64) Slot		// a cache line each, to keep threads off each other's
+	{	std::atomic<Route*> route;	// being read now, or 0 if idle
+		std::atomic<size_t> routes;
+		std::atomic<size_t> bytes;
+	};
+	static Slot *slots;
+	static unsigned int numslots;
+	static size_t total;
+	static unsigned short width;	// of the terminal
+	static std::chrono::steady_clock::time_point start_time, last_draw;
+	static std::mutex mtx;		// for waking the reporter when stopping
+	static std::condition_variable cv;
+	static bool running;
+
+	static void add(std::atomic<size_t> &, size_t);
+
+	public:
+	static const std::chrono::milliseconds interval;
+	static bool enabled;
+
+	static bool start(size_t, unsigned int);
+	static void reading(unsigned int, Route *);
+	static void read(unsigned int, size_t);
+	static void done(unsigned int);
+	static void draw();
+	static void tick();
+	static bool wait();
+	static void stop();
+	static void finish();
+};
@@ -1,6 +1,8 @@
 #include "Region.h"
+#include "../Arena/Arena.h"
 #include "../DBFieldLength/DBFieldLength.h"
 #include "../ErrorList/ErrorList.h"
+#include "../NameTable/NameTable.h"
 #include "../../functions/split.h"
 
 std::pair<std::string, std::string> *country_or_continent_by_code(std::string code, std::vector<std::pair<std::string, std::string>> &pair_vector)
@@ -10,7 +12,7 @@ std::pair<std::string, std::string> *country_or_continent_by_code(std::string co
 }
 
 std::vector<Region*> Region::allregions;
-std::unordered_map<std::string, Region*> Region::code_hash;
+NameTable<Region, 0> Region::code_hash;
 
 Region::Region (const std::string &line,
 		std::vector<std::pair<std::string, std::string>> &countries,
@@ -57,3 +59,11 @@ Region::Region (const std::string &line,
 		el.add_error("Region type > " + std::to_string(DBFieldLength::regiontype)
 			   + " bytes in regions.csv line " + line);
 }
+
+void* Region::operator new(size_t size)
+{	return Arena::allocate(size);
+}
+
+void Region::operator delete(void* p, size_t size)
+{	Arena::deallocate(p, size);
+}
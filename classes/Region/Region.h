@@ -1,5 +1,6 @@
 class ErrorList;
 class HGVertex;
+template <class T, bool fold_case> class NameTable;
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -49,10 +50,12 @@ class Region
 	bool is_valid;
 
 	static std::vector<Region*> allregions;
-	static std::unordered_map<std::string, Region*> code_hash;
+	static NameTable<Region, 0> code_hash;
 
 	Region (const std::string&,
 		std::vector<std::pair<std::string, std::string>>&,
 		std::vector<std::pair<std::string, std::string>>&,
 		ErrorList&);
+	static void* operator new(size_t);		// allocated from the calling thread's Arena
+	static void operator delete(void*, size_t);	// reclaimed only if it was the Arena's last allocation
 };
@@ -1,18 +1,23 @@
 #include "Route.h"
+#include "../Arena/Arena.h"
 #include "../DBFieldLength/DBFieldLength.h"
 #include "../ErrorList/ErrorList.h"
 #include "../HighwaySegment/HighwaySegment.h"
 #include "../HighwaySystem/HighwaySystem.h"
+#include "../NameTable/NameTable.h"
 #include "../Region/Region.h"
 #include "../TravelerList/TravelerList.h"
+#include "../Waypoint/Waypoint.h"
 #include "../../functions/lower.h"
 #include "../../functions/split.h"
 #include "../../functions/upper.h"
 #include <cstring>
 #include <fstream>
 
-std::unordered_map<std::string, Route*> Route::root_hash, Route::pri_list_hash, Route::alt_list_hash;
-std::unordered_set<std::string> Route::all_wpt_files;
+NameTable<Route, 1> Route::root_hash, Route::pri_list_hash, Route::alt_list_hash;
+std::vector<std::string> Route::wpt_dirs;
+std::unordered_map<std::string, unsigned int> Route::wpt_dir_ids;
+std::vector<std::unordered_set<std::string>> Route::all_wpt_files;
 std::mutex Route::awf_mtx;
 
 Route::Route(std::string &line, HighwaySystem *sys, ErrorList &el)
@@ -42,13 +47,12 @@ Route::Route(std::string &line, HighwaySystem *sys, ErrorList &el)
 		el.add_error("System mismatch parsing " + system->systemname
 			   + ".csv line [" + line + "], expected " + system->systemname);
 	// region
-	try {	region = Region::code_hash.at(rg_str);
-	    }
-	catch (const std::out_of_range& oor)
-	    {	el.add_error("Unrecognized region in " + system->systemname
+	region = Region::code_hash.find(rg_str);
+	if (!region)
+	{	el.add_error("Unrecognized region in " + system->systemname
 			   + ".csv line: " + line);
-		region = Region::code_hash.at("error");
-	    }
+		region = Region::code_hash.find("error");
+	}
 	// route
 	if (route.size() > DBFieldLength::route)
 		el.add_error("Route > " + std::to_string(DBFieldLength::route)
@@ -77,35 +81,84 @@ Route::Route(std::string &line, HighwaySystem *sys, ErrorList &el)
 	{	len = strcspn(arn_str.data()+pos, ",");
 		alt_route_names.emplace_back(arn_str, pos, len);
 	}
+}
 
-	// insert into root_hash, checking for duplicate root entries
-	if (!root_hash.insert(std::pair<std::string, Route*>(root, this)).second)
+void Route::insert_names(ErrorList &el)
+{	// insert into root_hash, checking for duplicate root entries
+	if (Route *r = root_hash.insert(root, this))
 		el.add_error("Duplicate root in " + system->systemname + ".csv: " + root +
-			     " already in " + root_hash.at(root)->system->systemname + ".csv");
+			     " already in " + r->system->systemname + ".csv");
 	// insert list name into pri_list_hash, checking for duplicate .list names
 	std::string list_name(readable_name());
-	upper(list_name.data());
-	if (alt_list_hash.find(list_name) != alt_list_hash.end())
+	if (Route *r = alt_list_hash.find(list_name))
 		el.add_error("Duplicate main list name in " + root + ": '" + readable_name() +
-			     "' already points to " + alt_list_hash.at(list_name)->root);
-	else if (!pri_list_hash.insert(std::pair<std::string,Route*>(list_name, this)).second)
+			     "' already points to " + r->root);
+	else if (Route *r = pri_list_hash.insert(list_name, this))
 		el.add_error("Duplicate main list name in " + root + ": '" + readable_name() +
-			     "' already points to " + pri_list_hash.at(list_name)->root);
+			     "' already points to " + r->root);
 	// insert alt names into alt_list_hash, checking for duplicate .list names
 	for (std::string& a : alt_route_names)
 	{   list_name = rg_str + ' ' + a;
 	    upper(list_name.data());
-	    if (pri_list_hash.find(list_name) != pri_list_hash.end())
+	    if (Route *r = pri_list_hash.find(list_name))
 		el.add_error("Duplicate alt route name in " + root + ": '" + region->code + ' ' + a +
-			     "' already points to " + pri_list_hash.at(list_name)->root);
-	    else if (!alt_list_hash.insert(std::pair<std::string, Route*>(list_name, this)).second)
+			     "' already points to " + r->root);
+	    else if (Route *r = alt_list_hash.insert(list_name, this))
 		el.add_error("Duplicate alt route name in " + root + ": '" + region->code + ' ' + a +
-			     "' already points to " + alt_list_hash.at(list_name)->root);
+			     "' already points to " + r->root);
 	    // populate unused set
 	    system->unusedaltroutenames.insert(list_name);
 	}
 }
 
+static void list_label(std::string &key, const char *label, size_t len)
+{	// a label as it's matched in .list files: upper case, minus any leading + or *
+	while (len && (*label == '+' || *label == '*')) {label++; len--;}
+	key.assign(label, len);
+	upper(key.data());
+}
+
+void Route::hash_labels()
+{	/* index every point's labels by their .list file form. The first
+	point to use a label keeps it; any other makes it a duplicate. */
+	std::string key;
+	pri_label_hash.reserve(point_list.size());
+	for (unsigned int i = 0; i < point_list.size(); i++)
+	{	Waypoint *w = point_list[i];
+		list_label(key, w->label, strlen(w->label));
+		if (alt_label_hash.count(key) || !pri_label_hash.emplace(key, i).second)
+			duplicate_labels.insert(key);
+		for (const char *a : w->alt_labels())
+		{	list_label(key, a, strlen(a));
+			if (pri_label_hash.count(key) || !alt_label_hash.emplace(key, i).second)
+				duplicate_labels.insert(key);
+			else	unused_alt_labels.insert(key);
+		}
+	}
+}
+
+unsigned int Route::find_label(const char *label, size_t len)
+{	/* return the point_list index of the point with a label as given
+	in a .list file, marking the label in use, or -1 if there's none.
+	Safe to call from any number of threads. */
+	static thread_local std::string key;
+	list_label(key, label, len);
+	unsigned int index;
+	auto p = pri_label_hash.find(key);
+	if (p != pri_label_hash.end()) index = p->second;
+	else {	auto a = alt_label_hash.find(key);
+		if (a == alt_label_hash.end()) return -1;
+		index = a->second;
+		ual_mtx.lock();
+		unused_alt_labels.erase(key);
+		ual_mtx.unlock();
+	     }
+	liu_mtx.lock();
+	labels_in_use.insert(key);
+	liu_mtx.unlock();
+	return index;
+}
+
 std::string Route::str()
 {	/* printable version of the object */
 	return root + " (" + std::to_string(point_list.size()) + " total points)";
@@ -115,3 +168,11 @@ std::string Route::readable_name()
 {	/* return a string for a human-readable route name */
 	return rg_str + " " + route + banner + abbrev;
 }
+
+void* Route::operator new(size_t size)
+{	return Arena::allocate(size);
+}
+
+void Route::operator delete(void* p, size_t size)
+{	Arena::deallocate(p, size);
+}
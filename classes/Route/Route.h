@@ -2,6 +2,7 @@ class ConnectedRoute;
 class ErrorList;
 class HighwaySegment;
 class HighwaySystem;
+template <class T, bool fold_case> class NameTable;
 class Region;
 class TravelerList;
 class Waypoint;
@@ -62,6 +63,7 @@ class Route
 	ConnectedRoute *con_route;
 
 	std::vector<Waypoint*> point_list;
+	std::vector<double> lat, lng;	// coordinate table for point_list, indexed by Waypoint::point_num
 	std::unordered_set<std::string> labels_in_use;
 	std::unordered_set<std::string> unused_alt_labels;
 	std::unordered_set<std::string> duplicate_labels;
@@ -72,15 +74,27 @@ class Route
 	std::string* last_update;
 	double mileage;
 	int rootOrder;
+	unsigned int index;	// position in system & route order, to report errors found in parallel in that order
 	bool is_reversed;
+	std::string snapshot;	// this Route's Snapshot entry, until written
 
-	static std::unordered_map<std::string, Route*> root_hash, pri_list_hash, alt_list_hash;
-	static std::unordered_set<std::string>	all_wpt_files;
-	static std::mutex awf_mtx;		// for locking the all_wpt_files set when erasing processed WPTs
+	static NameTable<Route, 1> root_hash, pri_list_hash, alt_list_hash;
+	static std::vector<std::string> wpt_dirs;			// dir id -> path relative to hwy_data
+	static std::unordered_map<std::string, unsigned int> wpt_dir_ids;// path relative to hwy_data -> dir id
+	static std::vector<std::unordered_set<std::string>> all_wpt_files;// dir id -> names of .wpt files not yet read
+	static std::mutex awf_mtx;		// for locking all_wpt_files when erasing processed WPTs
 
 	Route(std::string &, HighwaySystem *, ErrorList &);
+	static void* operator new(size_t);		// allocated from the calling thread's Arena
+	static void operator delete(void*, size_t);	// reclaimed only if it was the Arena's last allocation
 
+	void insert_names(ErrorList &);
 	std::string str();
 	void read_wpt(unsigned int, ErrorList *, bool);
+	void parse_wpt(const char *, size_t, bool);
+	void geometry(std::vector<double> &, std::vector<double> &);
+	void duplicate_coords(char *);
+	void hash_labels();
+	unsigned int find_label(const char *, size_t);
 	std::string readable_name();
 };
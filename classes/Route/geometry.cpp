@@ -0,0 +1,157 @@
+#include "Route.h"
+#include <cmath>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #define AVX2_KERNELS
+#endif
+
+#define pi 3.141592653589793238
+
+/* Batch kernels for the segment lengths and interior angles of a whole
+Route, computed from its coordinate table.
+
+Each point's sin & cos are computed once, instead of once for every
+segment or angle the point takes part in. The arithmetic between the
+libm calls runs 4 points at a time with AVX2 when the CPU has it. The
+libm calls themselves (including pow(x,2), which doesn't always round
+the same as x*x) and the order of every operation are the same as in
+Waypoint::distance & Waypoint::angle, so the results are bit-identical
+and LONG_SEGMENT, VISIBLE_DISTANCE & SHARP_ANGLE are unaffected. */
+
+struct GeometryScratch
+{	std::vector<double> rlat, rlng, coslat, sinlat, coslng, sinlng;	// per point
+	std::vector<double> x, y, z;					// per point
+	std::vector<double> hlat, hlng, plat, plng, root;		// per segment
+	std::vector<double> ratio;					// per point; ends unused
+};
+
+// scalar versions of the vectorizable steps, also used for leftover elements
+
+static inline void xyz_scalar(GeometryScratch &s, size_t i)
+{	s.x[i] = s.coslng[i]*s.coslat[i];
+	s.y[i] = s.sinlng[i]*s.coslat[i];
+	s.z[i] = s.sinlat[i];
+}
+
+static inline void halves_scalar(GeometryScratch &s, size_t i)
+{	s.hlat[i] = (s.rlat[i+1]-s.rlat[i])/2;
+	s.hlng[i] = (s.rlng[i+1]-s.rlng[i])/2;
+}
+
+static inline void root_scalar(GeometryScratch &s, size_t i)
+{	s.root[i] = sqrt(s.plat[i] + s.coslat[i] * s.coslat[i+1] * s.plng[i]);
+}
+
+static inline void ratio_scalar(GeometryScratch &s, size_t i)
+{	double dx1 = s.x[i]-s.x[i-1];	double dx2 = s.x[i+1]-s.x[i];
+	double dy1 = s.y[i]-s.y[i-1];	double dy2 = s.y[i+1]-s.y[i];
+	double dz1 = s.z[i]-s.z[i-1];	double dz2 = s.z[i+1]-s.z[i];
+	s.ratio[i] = ( dx2*dx1 + dy2*dy1 + dz2*dz1 )
+	     / sqrt( ( dx2*dx2 + dy2*dy2 + dz2*dz2 ) * ( dx1*dx1 + dy1*dy1 + dz1*dz1 ) );
+}
+
+static void prep_scalar(GeometryScratch &s, size_t n)
+{	for (size_t i = 0; i < n; i++) xyz_scalar(s, i);
+	for (size_t i = 0; i+1 < n; i++) halves_scalar(s, i);
+}
+
+static void finish_scalar(GeometryScratch &s, size_t n)
+{	for (size_t i = 0; i+1 < n; i++) root_scalar(s, i);
+	for (size_t i = 1; i+1 < n; i++) ratio_scalar(s, i);
+}
+
+#ifdef AVX2_KERNELS
+// No FMA here: a fused multiply-add would round differently than the scalar code.
+__attribute__((target("avx2")))
+static void prep_avx2(GeometryScratch &s, size_t n)
+{	size_t i = 0;
+	for (; i+4 <= n; i += 4)
+	{	__m256d cl = _mm256_loadu_pd(&s.coslat[i]);
+		_mm256_storeu_pd(&s.x[i], _mm256_mul_pd(_mm256_loadu_pd(&s.coslng[i]), cl));
+		_mm256_storeu_pd(&s.y[i], _mm256_mul_pd(_mm256_loadu_pd(&s.sinlng[i]), cl));
+		_mm256_storeu_pd(&s.z[i], _mm256_loadu_pd(&s.sinlat[i]));
+	}
+	for (; i < n; i++) xyz_scalar(s, i);
+	const __m256d two = _mm256_set1_pd(2);
+	for (i = 0; i+5 <= n; i += 4)
+	{	__m256d dlat = _mm256_sub_pd(_mm256_loadu_pd(&s.rlat[i+1]), _mm256_loadu_pd(&s.rlat[i]));
+		__m256d dlng = _mm256_sub_pd(_mm256_loadu_pd(&s.rlng[i+1]), _mm256_loadu_pd(&s.rlng[i]));
+		_mm256_storeu_pd(&s.hlat[i], _mm256_div_pd(dlat, two));
+		_mm256_storeu_pd(&s.hlng[i], _mm256_div_pd(dlng, two));
+	}
+	for (; i+1 < n; i++) halves_scalar(s, i);
+}
+
+__attribute__((target("avx2")))
+static void finish_avx2(GeometryScratch &s, size_t n)
+{	size_t i = 0;
+	for (; i+5 <= n; i += 4)
+	{	__m256d c1c2 = _mm256_mul_pd(_mm256_loadu_pd(&s.coslat[i]), _mm256_loadu_pd(&s.coslat[i+1]));
+		__m256d sum = _mm256_add_pd(_mm256_loadu_pd(&s.plat[i]), _mm256_mul_pd(c1c2, _mm256_loadu_pd(&s.plng[i])));
+		_mm256_storeu_pd(&s.root[i], _mm256_sqrt_pd(sum));
+	}
+	for (; i+1 < n; i++) root_scalar(s, i);
+	#define DIFFS(C) \
+		__m256d C##0 = _mm256_loadu_pd(&s.C[i-1]); \
+		__m256d C##1 = _mm256_loadu_pd(&s.C[i]); \
+		__m256d C##2 = _mm256_loadu_pd(&s.C[i+1]); \
+		__m256d d##C##1 = _mm256_sub_pd(C##1, C##0); \
+		__m256d d##C##2 = _mm256_sub_pd(C##2, C##1);
+	for (i = 1; i+5 <= n; i += 4)
+	{	DIFFS(x) DIFFS(y) DIFFS(z)
+		__m256d dot = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx2, dx1), _mm256_mul_pd(dy2, dy1)), _mm256_mul_pd(dz2, dz1));
+		__m256d len2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx2, dx2), _mm256_mul_pd(dy2, dy2)), _mm256_mul_pd(dz2, dz2));
+		__m256d len1 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx1, dx1), _mm256_mul_pd(dy1, dy1)), _mm256_mul_pd(dz1, dz1));
+		_mm256_storeu_pd(&s.ratio[i], _mm256_div_pd(dot, _mm256_sqrt_pd(_mm256_mul_pd(len2, len1))));
+	}
+	#undef DIFFS
+	for (; i+1 < n; i++) ratio_scalar(s, i);
+}
+#endif
+
+void Route::geometry(std::vector<double> &lengths, std::vector<double> &angles)
+{	/* lengths[i] = distance in miles from point i to point i+1
+	   angles[i]  = angle in degrees at interior point i (0 at each end;
+			NaN where it coincides with a neighbor) */
+	static thread_local GeometryScratch s;
+	size_t n = lat.size();
+	lengths.resize(n ? n-1 : 0);
+	angles.assign(n, 0);
+	if (n < 2) return;
+	#define RESIZE(V) s.V.resize(n);
+	RESIZE(rlat) RESIZE(rlng) RESIZE(coslat) RESIZE(sinlat) RESIZE(coslng) RESIZE(sinlng)
+	RESIZE(x) RESIZE(y) RESIZE(z) RESIZE(hlat) RESIZE(hlng) RESIZE(plat) RESIZE(plng) RESIZE(root) RESIZE(ratio)
+	#undef RESIZE
+
+	// convert to radians; each point's trig, once
+	for (size_t i = 0; i < n; i++)
+	{	s.rlat[i] = lat[i] * (pi/180);
+		s.rlng[i] = lng[i] * (pi/180);
+		s.coslat[i] = cos(s.rlat[i]);
+		s.sinlat[i] = sin(s.rlat[i]);
+		s.coslng[i] = cos(s.rlng[i]);
+		s.sinlng[i] = sin(s.rlng[i]);
+	}
+      #ifdef AVX2_KERNELS
+	static const bool avx2 = __builtin_cpu_supports("avx2");
+	if (avx2) prep_avx2(s, n); else
+      #endif
+	prep_scalar(s, n);
+	// haversine formula, per segment
+	for (size_t i = 0; i+1 < n; i++)
+	{	s.plat[i] = pow(sin(s.hlat[i]),2);
+		s.plng[i] = pow(sin(s.hlng[i]),2);
+	}
+      #ifdef AVX2_KERNELS
+	if (avx2) finish_avx2(s, n); else
+      #endif
+	finish_scalar(s, n);
+	for (size_t i = 0; i+1 < n; i++)
+	{	double ans = asin(s.root[i]) * 7926.2; /* EARTH_DIAMETER */
+		lengths[i] = ans * 1.02112; // CHM/TM distance fudge factor to compensate for imprecision of mapping
+	}
+	for (size_t i = 1; i+1 < n; i++)
+		angles[i] = acos(s.ratio[i])*180/pi;
+}
+
+#undef pi
@@ -1,147 +1,222 @@
-#define debug
-#ifdef debug
-  #include "../TravelerList/TravelerList.h"
-  #define COND if (system->systemname == "usaca" || system->systemname == "usaal" || system->systemname == "usafl")
-  #define DEBUG(WHAT) WHAT
-  #define   LOCK TravelerList::mtx.lock() /* repurpose a mutex not doing anything */
-  #define UNLOCK TravelerList::mtx.unlock() /* else ATM for locking terminal */
-#else
-  #define DEBUG(WHAT)
-#endif
-
 #include "Route.h"
 #include "../Args/Args.h"
 #include "../Datacheck/Datacheck.h"
 #include "../ErrorList/ErrorList.h"
 #include "../HighwaySegment/HighwaySegment.h"
 #include "../HighwaySystem/HighwaySystem.h"
+#include "../Metrics/Metrics.h"
+#include "../Progress/Progress.h"
+#include "../Snapshot/Snapshot.h"
+#include "../Trace/Trace.h"
 #include "../Waypoint/Waypoint.h"
+#include "../../functions/coord_hash.h"
 #include <cstring>
-#include <fstream>
-#include <unordered_set>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 void Route::read_wpt(unsigned int threadnum, ErrorList *el, bool usa_flag)
 {	/* read data into the Route's waypoint list from a .wpt file */
 	//cout << "read_wpt on " << str() << endl;
-	std::string filename = Args::highwaydatapath + "/hwy_data" + "/" + rg_str + "/" + system->systemname + "/" + root + ".wpt";
-	// remove full path from all_wpt_files list
-	awf_mtx.lock();
-	all_wpt_files.erase(filename);
-	awf_mtx.unlock();
-	std::vector<char*> lines;
-	std::ifstream file(filename);
-	if (!file)
-	{	el->add_error("[Errno 2] No such file or directory: '" + filename + '\'');
-		file.close();
-		return;
+	std::string dir = rg_str + "/" + system->systemname;
+	std::string filename = Args::highwaydatapath + "/hwy_data" + "/" + dir + "/" + root + ".wpt";
+	Metrics::count(Metrics::ROUTES, 1);
+	// remove (dir id, name) from all_wpt_files list
+	auto d = wpt_dir_ids.find(dir);
+	if (d != wpt_dir_ids.end())
+	{	awf_mtx.lock();
+		all_wpt_files[d->second].erase(root + ".wpt");
+		awf_mtx.unlock();
 	}
-	file.seekg(0, std::ios::end);
-	unsigned long wptdatasize = file.tellg();
-	file.seekg(0, std::ios::beg);
-	char *wptdata = new char[wptdatasize+1];
-	file.read(wptdata, wptdatasize);
-	wptdata[wptdatasize] = 0; // add null terminator
-	file.close();
 
-	DEBUG(COND{LOCK; std::cout << "ReadWptThread " << threadnum << ' ' << root << " slurped" << std::endl; UNLOCK;})
+	// find this file's Snapshot entry, if any
+	std::string path;
+	const char *entry = 0;
+	uint64_t context = 0;
+	if (Snapshot::enabled)
+	{	path = dir + "/" + root + ".wpt";
+		context = Snapshot::context(this, usa_flag);
+		entry = Snapshot::find(path);
+	}
+	// in incremental mode, a file not listed as changed is taken from the
+	// snapshot unopened; otherwise if size & mtime say the file's
+	// unchanged, there's no need to read it
+	TRACE(uint64_t read_begin = Trace::now();)
+	struct stat buf;
+	int fd = -1;
+	if (!entry || !Snapshot::trust(entry, path, context, buf))
+	{	fd = open(filename.data(), O_RDONLY);
+		if (fd < 0)
+		{	el->add_error("[Errno 2] No such file or directory: '" + filename + '\'');
+			return;
+		}
+		if (fstat(fd, &buf))
+		{	el->add_error("Could not stat " + filename);
+			close(fd);
+			return;
+		}
+		Metrics::count(Metrics::FILES, 1);
+		Metrics::count(Metrics::BYTES, buf.st_size);
+	}
+	size_t wptdatasize = buf.st_size;
+	Progress::read(threadnum, wptdatasize);
+	bool reuse = entry && Snapshot::current(entry, buf, context);
+	if (!reuse)
+	{	// map the file read-only and parse straight from the mapping; mmap
+		// can't map 0 bytes, so an empty file just yields no lines at all
+		char *wptdata = 0;
+		if (wptdatasize)
+		{	wptdata = (char*)mmap(0, wptdatasize, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (wptdata == MAP_FAILED)
+			{	el->add_error("Could not map " + filename + " into memory");
+				close(fd);
+				return;
+			}
+			madvise(wptdata, wptdatasize, MADV_SEQUENTIAL);
+		}
+		close(fd);
 
-	// split file into lines
-	size_t spn = 0;
-	for (char* c = wptdata; *c; c += spn)
-	{	for (spn = strcspn(c, "\n\r"); c[spn] == '\n' || c[spn] == '\r'; spn++) c[spn] = 0;
-		lines.emplace_back(c);
+		// the mtime may have changed without the contents changing
+		uint64_t hash = Snapshot::enabled ? Snapshot::hash(wptdata, wptdatasize) : 0;
+		TRACE(Trace::record("read", root.data(), read_begin, Trace::now());)
+		reuse = entry && Snapshot::same_content(entry, wptdatasize, hash, context);
+		if (!reuse)
+		{	size_t first_dc = Datacheck::thread_buffer().size();
+			parse_wpt(wptdata, wptdatasize, usa_flag);
+			if (Snapshot::enabled) snapshot = Snapshot::entry(this, path, buf, hash, context, first_dc);
+		}
+		if (wptdata) munmap(wptdata, wptdatasize);
+	}
+	else if (fd >= 0) close(fd);
+	if (reuse)
+	{	TRACE_SPAN("restore", root.data());
+		Snapshot::restore(this, entry);
+		snapshot = Snapshot::touch(entry, buf);
 	}
 
-	lines.push_back(wptdata+wptdatasize+1); // add a dummy "past-the-end" element to make lines[l+1]-2 work
-	// set to be used for finding duplicate coordinates
-	std::unordered_set<Waypoint*> coords_used;
-	double vis_dist = 0;
-	Waypoint *last_visible = 0;
-	char fstr[112];
+	hash_labels();
+	Metrics::count(Metrics::WAYPOINTS, point_list.size());
+	Metrics::count(Metrics::SEGMENTS, segment_list.size());
+	if (point_list.size() < 2) el->add_error("Route contains fewer than 2 points: " + str());
+	//std::cout << str() << std::flush;
+	//print_route();
+}
 
-	DEBUG(COND{LOCK; std::cout << "ReadWptThread " << threadnum << ' ' << root << " split into lines" << std::endl; UNLOCK;})
+void Route::parse_wpt(const char *wptdata, size_t wptdatasize, bool usa_flag)
+{	/* parse the text of a .wpt file into the Route's waypoint list
+	and segments, running datachecks along the way */
+	TRACE(uint64_t parse_begin = Trace::now();)
+	char fstr[112];
+	Waypoint::LabelContext label_context(this, usa_flag);
 
-	for (unsigned int l = 0; l < lines.size()-1; l++)
-	{	DEBUG(COND{LOCK; std::cout << "ReadWptThread " << threadnum << "   " << lines[l] << std::endl; UNLOCK;})
+	const char *end = wptdata+wptdatasize;
+	const char *eol;
+	for (const char *c = wptdata; c < end; c = eol)
+	{	// find end of line, and the start of the next non-blank line
+		for (eol = c; eol < end && *eol != '\n' && *eol != '\r'; eol++);
+		const char *line_end = eol;
+		while (eol < end && (*eol == '\n' || *eol == '\r')) eol++;
 		// strip whitespace
-		while (lines[l][0] == ' ' || lines[l][0] == '\t') lines[l]++;
-		char * endchar = lines[l+1]-2; // -2 skips over the 0 inserted while splitting wptdata into lines
-		while (*endchar == 0) endchar--;  // skip back more for CRLF cases, and lines followed by blank lines
-		while (*endchar == ' ' || *endchar == '\t')
-		{	*endchar = 0;
-			endchar--;
-		}
-		DEBUG(COND{LOCK; std::cout << "ReadWptThread " << threadnum << "     whitespace stripped" << std::endl; UNLOCK;})
-		if (lines[l][0] == 0) continue;
-		Waypoint *w = new Waypoint(lines[l], this);
+		while (c < line_end && (*c == ' ' || *c == '\t')) c++;
+		while (line_end > c && (line_end[-1] == ' ' || line_end[-1] == '\t')) line_end--;
+		if (c == line_end) continue;
+		Waypoint *w = new Waypoint(c, line_end, this);
 			      // deleted on termination of program, or immediately below if invalid
-		DEBUG(COND{LOCK; std::cout << "ReadWptThread " << threadnum << "     new Waypoint" << std::endl; UNLOCK;})
-		bool malformed_url = w->lat == 0 && w->lng == 0;
+		bool malformed_url = lat.back() == 0 && lng.back() == 0;
 		bool label_too_long = w->label_too_long();
-		DEBUG(COND{LOCK; std::cout << "ReadWptThread " << threadnum << "     label_too_long() returned" << std::endl; UNLOCK;})
 		if (malformed_url || label_too_long)
-		{	delete w;
+		{	lat.pop_back();
+			lng.pop_back();
+			delete w;
 			continue;
 		}
 		point_list.push_back(w);
-		DEBUG(COND{LOCK; std::cout << "ReadWptThread " << threadnum << "     " << w->str() << " point_list.push_back(w)" << std::endl; UNLOCK;})
 
-		// single-point Datachecks, and HighwaySegment
-		w->out_of_bounds(fstr);
-		w->duplicate_coords(coords_used, fstr);
-		w->label_invalid_char();
-		if (point_list.size() > 1)
-		{	w->distance_update(fstr, vis_dist, point_list[point_list.size()-2]);
-			// add HighwaySegment, if not first point
-			segment_list.push_back(new HighwaySegment(point_list[point_list.size()-2], w, this));
-					       // deleted on termination of program
+		// single-point Datachecks
+		w->label_datachecks(label_context);
+	}
+	TRACE(Trace::record("parse", root.data(), parse_begin, Trace::now());)
+	TRACE_SPAN("datachecks", root.data());
+
+	duplicate_coords(fstr);
+	// geometry passes over the coordinate table
+	static thread_local std::vector<double> lengths, angles;
+	geometry(lengths, angles);
+	// out-of-bounds coords
+	for (unsigned int i = 0; i < lat.size(); i++)
+	  if (lat[i] > 90 || lat[i] < -90 || lng[i] > 180 || lng[i] < -180)
+	  {	sprintf(fstr, "(%.15g,%.15g)", lat[i], lng[i]);
+		Datacheck::add(this, point_list[i]->label, "", "", Datacheck::OUT_OF_BOUNDS, fstr);
+	  }
+	// HighwaySegments, with segment length & visible distance checks
+	double vis_dist = 0;
+	unsigned int last_visible = 0;
+	for (unsigned int i = 1; i < lat.size(); i++)
+	{	double length = lengths[i-1];
+		segment_list.push_back(new HighwaySegment(point_list[i-1], point_list[i], this, length));
+				       // deleted on termination of program
+		vis_dist += length;
+		if (length > 20)
+		{	sprintf(fstr, "%.2f", length);
+			Datacheck::add(this, point_list[i-1]->label, point_list[i]->label, "", Datacheck::LONG_SEGMENT, fstr);
 		}
-		DEBUG(COND{LOCK; std::cout << "ReadWptThread " << threadnum << "     new HighwaySegment" << std::endl; UNLOCK;})
-		// checks for visible points
-		if (!w->is_hidden)
-		{	const char *slash = strchr(w->label.data(), '/');
-			if (usa_flag && w->label.size() >= 2)
-			{	w->bus_with_i();
-				w->interstate_no_hyphen();
-				w->us_letter();
+		if (!point_list[i]->is_hidden)
+		{	// complete visible distance check, omit report for active
+			// systems to reduce clutter
+			if (vis_dist > 10 && !system->active())
+			{	sprintf(fstr, "%.2f", vis_dist);
+				Datacheck::add(this, point_list[last_visible]->label, point_list[i]->label, "", Datacheck::VISIBLE_DISTANCE, fstr);
 			}
-			w->label_invalid_ends();
-			w->label_looks_hidden();
-			w->label_parens();
-			w->label_selfref(slash);
-			w->label_slashes(slash);
-			w->lacks_generic();
-			w->underscore_datachecks(slash);
-			w->visible_distance(fstr, vis_dist, last_visible);
+			last_visible = i;
+			vis_dist = 0;
 		}
-		DEBUG(COND{LOCK; std::cout << "ReadWptThread " << threadnum << "     checks for visible points OK" << std::endl; UNLOCK;})
 	}
-	DEBUG(COND{LOCK; std::cout << "ReadWptThread " << threadnum << " delete[] " << std::flush; UNLOCK;})
-	delete[] wptdata;
-	DEBUG(COND{LOCK; std::cout << "wptdata;" << std::endl; UNLOCK;})
 
 	// per-route datachecks
-	if (point_list.size() < 2) el->add_error("Route contains fewer than 2 points: " + str());
-	else {	// look for hidden termini
-		if (point_list.front()->is_hidden)	Datacheck::add(this, point_list.front()->label, "", "", "HIDDEN_TERMINUS", "");
-		if (point_list.back()->is_hidden)	Datacheck::add(this, point_list.back()->label, "", "", "HIDDEN_TERMINUS", "");
+	if (point_list.size() >= 2)
+	{	// look for hidden termini
+		if (point_list.front()->is_hidden)	Datacheck::add(this, point_list.front()->label, "", "", Datacheck::HIDDEN_TERMINUS, "");
+		if (point_list.back()->is_hidden)	Datacheck::add(this, point_list.back()->label, "", "", Datacheck::HIDDEN_TERMINUS, "");
 
 		// angle check is easier with a traditional for loop and array indices
 		for (unsigned int i = 1; i < point_list.size()-1; i++)
 		{	//cout << "computing angle for " << point_list[i-1].str() << ' ' << point_list[i].str() << ' ' << point_list[i+1].str() << endl;
-			if (point_list[i-1]->same_coords(point_list[i]) || point_list[i+1]->same_coords(point_list[i]))
-				Datacheck::add(this, point_list[i-1]->label, point_list[i]->label, point_list[i+1]->label, "BAD_ANGLE", "");
-			else {	double angle = point_list[i]->angle(point_list[i-1], point_list[i+1]);
-				if (angle > 135)
-				{	sprintf(fstr, "%.2f", angle);
-					Datacheck::add(this, point_list[i-1]->label, point_list[i]->label, point_list[i+1]->label, "SHARP_ANGLE", fstr);
-				}
-			     }
+			if (lat[i-1] == lat[i] && lng[i-1] == lng[i] || lat[i+1] == lat[i] && lng[i+1] == lng[i])
+				Datacheck::add(this, point_list[i-1]->label, point_list[i]->label, point_list[i+1]->label, Datacheck::BAD_ANGLE, "");
+			else if (angles[i] > 135)
+			{	sprintf(fstr, "%.2f", angles[i]);
+				Datacheck::add(this, point_list[i-1]->label, point_list[i]->label, point_list[i+1]->label, Datacheck::SHARP_ANGLE, fstr);
+			}
 		}
-	     }
-	DEBUG(LOCK;) // repurpose a mutex not doing anything ATM for locking terminal
-	std::cout << '.' << std::flush;
-	DEBUG(UNLOCK;)
-	//std::cout << str() << std::flush;
-	//print_route();
+	}
+}
+
+void Route::duplicate_coords(char *fstr)
+{	/* flag each point at the same coordinates as an earlier point in
+	this route, once per earlier point, in point order. A hash table
+	keyed on exact coordinates holds the first & last points at each
+	location, and next chains each point to the next one there, so
+	one lookup finds every earlier duplicate. */
+	struct Location {unsigned int first, last;};	// point indices + 1; 0 if empty
+	static thread_local std::vector<Location> table;
+	static thread_local std::vector<unsigned int> next;
+	size_t capacity = 16;
+	while (capacity < 2*lat.size()) capacity *= 2;
+	table.assign(capacity, Location{0, 0});
+	next.assign(lat.size(), 0);
+	for (unsigned int i = 0; i < lat.size(); i++)
+	{	size_t s = coord_hash(lat[i], lng[i]) & (capacity-1);
+		while (table[s].first && (lat[table[s].first-1] != lat[i] || lng[table[s].first-1] != lng[i]))
+			s = (s+1) & (capacity-1);
+		if (!table[s].first)
+		{	table[s].first = table[s].last = i+1;
+			continue;
+		}
+		sprintf(fstr, "(%.15g,%.15g)", lat[i], lng[i]);
+		for (unsigned int o = table[s].first; o; o = next[o-1])
+			Datacheck::add(this, point_list[o-1]->label, point_list[i]->label, "", Datacheck::DUPLICATE_COORDS, fstr);
+		next[table[s].last-1] = i+1;
+		table[s].last = i+1;
+	}
 }
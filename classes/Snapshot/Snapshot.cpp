@@ -0,0 +1,350 @@
+#include "Snapshot.h"
+#include "../Datacheck/Datacheck.h"
+#include "../ErrorList/ErrorList.h"
+#include "../HighwaySegment/HighwaySegment.h"
+#include "../HighwaySystem/HighwaySystem.h"
+#include "../Route/Route.h"
+#include "../Waypoint/Waypoint.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// bump whenever the entry layout, or anything read_wpt stores in it, changes
+const uint32_t Snapshot::version = 3;
+static const char magic[8] = {'T','M','S','N','A','P','\0','\0'};
+static const size_t header_size = sizeof(magic) + 2*sizeof(uint32_t);
+// offset of the mtime fields within an entry
+static const size_t mtime_offset = sizeof(uint32_t) + sizeof(uint64_t);
+
+char *Snapshot::data = 0;
+size_t Snapshot::size = 0;
+std::unordered_map<std::string, const char*> Snapshot::entries;
+bool Snapshot::enabled = 0;
+bool Snapshot::incremental = 0;
+std::unordered_set<std::string> Snapshot::changed;
+
+// reading & writing fields
+
+template <class T> static inline T get(const char *&p)
+{	T value;
+	memcpy(&value, p, sizeof(T));
+	p += sizeof(T);
+	return value;
+}
+
+static inline const char* get_str(const char *&p)
+{	uint32_t len = get<uint32_t>(p);
+	const char *str = p;
+	p += len+1;
+	return str;
+}
+
+template <class T> static inline void put(std::string &s, T value)
+{	s.append((const char*)&value, sizeof(T));
+}
+
+static inline void put_str(std::string &s, const char *str, size_t len)
+{	put<uint32_t>(s, len);
+	s.append(str, len+1);
+}
+
+static inline void put_str(std::string &s, const char *str)
+{	put_str(s, str, strlen(str));
+}
+
+// validating entries, without reading past their end
+
+static bool skip(const char *&p, const char *end, size_t n)
+{	if (size_t(end-p) < n) return 0;
+	p += n;
+	return 1;
+}
+
+static bool skip_str(const char *&p, const char *end, uint32_t strings = 1)
+{	/* step over a str holding that many NUL-terminated strings back to
+	back, the last terminated by the str's own NUL */
+	uint32_t len;
+	if (size_t(end-p) < sizeof(len)) return 0;
+	len = get<uint32_t>(p);
+	if (size_t(end-p) <= len) return 0;
+	const char *q = p, *str_end = p+len+1;
+	for (; strings; strings--)
+	{	q = (const char*)memchr(q, 0, str_end-q);
+		if (!q) return 0;
+		q++;
+	}
+	if (q != str_end) return 0;
+	p = str_end;
+	return 1;
+}
+
+static bool valid(const char *e, const char *end)
+{	/* whether every count, string & code in entry e checks out,
+	and they add up to exactly its length */
+	const char *p = e;
+	if (!skip(p, end, mtime_offset + 2*sizeof(int64_t) + 2*sizeof(uint64_t))) return 0;
+	if (!skip_str(p, end)) return 0;	// path
+	if (size_t(end-p) < sizeof(uint32_t)) return 0;
+	uint32_t points = get<uint32_t>(p);
+	for (uint32_t i = 0; i < points; i++)
+	{	if (!skip(p, end, 2*sizeof(double))) return 0;
+		if (size_t(end-p) < sizeof(uint32_t)) return 0;
+		uint32_t alts = get<uint32_t>(p);
+		if (alts > 0xFFFF || !skip_str(p, end, alts+1)) return 0;
+	}
+	if (points && !skip(p, end, (points-1)*sizeof(double))) return 0;
+	if (size_t(end-p) < sizeof(uint32_t)) return 0;
+	for (uint32_t d = get<uint32_t>(p); d; d--)
+	{	if (!skip(p, end, 1) || (unsigned char)p[-1] > Datacheck::VISIBLE_HIDDEN_COLOC) return 0;	// the last code
+		for (int s = 0; s < 4; s++)
+		  if (!skip_str(p, end)) return 0;
+	}
+	return p == end;
+}
+
+// loading & saving
+
+size_t Snapshot::load(std::string filename)
+{	/* map filename & index its entries; return how many there are.
+	A missing or outdated file yields no entries, and any entry that
+	runs past the end of the file or doesn't check out is dropped. */
+	enabled = 1;
+	int fd = open(filename.data(), O_RDONLY);
+	if (fd < 0) return 0;
+	struct stat buf;
+	fstat(fd, &buf);
+	if (buf.st_size < (off_t)header_size)
+	{	close(fd);
+		return 0;
+	}
+	data = (char*)mmap(0, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{	data = 0;
+		return 0;
+	}
+	size = buf.st_size;
+	const char *p = data+sizeof(magic);
+	uint32_t v = get<uint32_t>(p);
+	uint32_t count = get<uint32_t>(p);
+	if (memcmp(data, magic, sizeof(magic)) || v != version) return 0;
+	const char *end = data+size;
+	for (uint32_t i = 0; i < count && p+sizeof(uint32_t) <= end; i++)
+	{	const char *e = p;
+		uint32_t len = get<uint32_t>(p);
+		if (len < sizeof(len) || len > end-e) break;
+		p = e + mtime_offset + 2*sizeof(int64_t) + 2*sizeof(uint64_t);
+		if (valid(e, e+len)) entries[get_str(p)] = e;
+		p = e+len;
+	}
+	return entries.size();
+}
+
+bool Snapshot::write(std::string filename)
+{	/* write every Route's entry to filename, in system & route order,
+	freeing them as we go. Written to a temp file first & renamed, so
+	a mapping of the previous snapshot stays intact. */
+	std::string tmp = filename + ".tmp";
+	FILE *f = fopen(tmp.data(), "wb");
+	if (!f) return 0;
+	uint32_t count = 0;
+	fwrite(magic, sizeof(magic), 1, f);
+	fwrite(&version, sizeof(version), 1, f);
+	fwrite(&count, sizeof(count), 1, f);
+	for (HighwaySystem *h : HighwaySystem::syslist)
+	  for (Route *r : h->route_list)
+	    if (r->snapshot.size())
+	    {	fwrite(r->snapshot.data(), r->snapshot.size(), 1, f);
+		std::string().swap(r->snapshot);
+		count++;
+	    }
+	fseek(f, sizeof(magic)+sizeof(version), SEEK_SET);
+	fwrite(&count, sizeof(count), 1, f);
+	bool ok = !ferror(f);
+	ok = !fclose(f) && ok;
+	return ok && !rename(tmp.data(), filename.data());
+}
+
+bool Snapshot::holds(const char *p)
+{	/* whether p points into the mapped snapshot */
+	return data && p >= data && p < data+size;
+}
+
+const char* Snapshot::find(std::string &path)
+{	/* return the entry for path, or 0 if there's none */
+	auto e = entries.find(path);
+	return e == entries.end() ? 0 : e->second;
+}
+
+uint64_t Snapshot::file_size(std::string &path)
+{	/* return the size path's file had when the snapshot was written, or 0 if it has no entry */
+	const char *p = find(path);
+	if (!p) return 0;
+	p += sizeof(uint32_t);
+	return get<uint64_t>(p);
+}
+
+size_t Snapshot::list_changed(std::list<std::string> &files, std::string &listfile, std::string &hwydatapath, ErrorList &el)
+{	/* switch to incremental mode, with the changed files given on the
+	command line & in listfile, one per line; return how many are under
+	hwy_data. Paths can be relative to hwydatapath (as git reports them)
+	or include it; a .wpt file anywhere else is an error, as its snapshot
+	entry could otherwise be trusted stale. */
+	incremental = 1;
+	if (listfile.size())
+	{	std::ifstream file(listfile);
+		if (!file) el.add_error("Could not open changed files list " + listfile);
+		std::string line;
+		while (getline(file, line))
+		{	if (line.size() && line.back() == 0x0D) line.erase(line.end()-1);	// trim DOS newlines
+			if (line.size()) files.push_back(line);
+		}
+	}
+	for (std::string &f : files)
+	{	const char *p = f.data();
+		if (!f.compare(0, hwydatapath.size()+1, hwydatapath+'/')) p += hwydatapath.size()+1;
+		while (!strncmp(p, "./", 2)) p += 2;
+		if (!strncmp(p, "hwy_data/", 9)) changed.emplace(p+9);
+		else if (f.size() >= 4 && !f.compare(f.size()-4, 4, ".wpt"))
+			el.add_error("Changed file " + f + " is not in " + hwydatapath + "/hwy_data");
+	}
+	return changed.size();
+}
+
+// keys
+
+uint64_t Snapshot::hash(const char *p, size_t len)
+{	/* 64-bit content hash, 8 bytes at a time */
+	uint64_t h = 0x9E3779B97F4A7C15ULL ^ len;
+	for (; len >= 8; p += 8, len -= 8)
+	{	uint64_t w;
+		memcpy(&w, p, 8);
+		h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 32;
+	}
+	for (; len; p++, len--)
+	{	h = (h ^ (unsigned char)*p) * 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 32;
+	}
+	return h;
+}
+
+uint64_t Snapshot::context(Route *r, bool usa_flag)
+{	/* hash of what read_wpt's datachecks depend on besides the .wpt itself */
+	std::string c = r->system->systemname + ';' + r->rg_str + ';' + r->route + ';' + r->banner
+		      + ';' + r->abbrev + ';' + r->city + ';' + r->root + ';' + char('0'+usa_flag)
+		      + char('0'+r->system->active());
+	return hash(c.data(), c.size());
+}
+
+bool Snapshot::current(const char *e, struct stat &buf, uint64_t context)
+{	/* whether entry e matches a file's size & mtime, and the route's context */
+	const char *p = e + sizeof(uint32_t);
+	if (get<uint64_t>(p) != (uint64_t)buf.st_size) return 0;
+	if (get<int64_t>(p) != buf.st_mtim.tv_sec) return 0;
+	if (get<int64_t>(p) != buf.st_mtim.tv_nsec) return 0;
+	get<uint64_t>(p);
+	return get<uint64_t>(p) == context;
+}
+
+bool Snapshot::same_content(const char *e, size_t filesize, uint64_t hash, uint64_t context)
+{	/* whether entry e matches a file's size & content hash, and the route's context */
+	const char *p = e + sizeof(uint32_t);
+	if (get<uint64_t>(p) != filesize) return 0;
+	p += 2*sizeof(int64_t);
+	if (get<uint64_t>(p) != hash) return 0;
+	return get<uint64_t>(p) == context;
+}
+
+bool Snapshot::trust(const char *e, std::string &path, uint64_t context, struct stat &buf)
+{	/* whether, in incremental mode, entry e can stand in for a file that
+	wasn't listed as changed, sight unseen; if so, fill in buf from e */
+	if (!incremental || changed.count(path)) return 0;
+	const char *p = e + sizeof(uint32_t);
+	uint64_t filesize = get<uint64_t>(p);
+	int64_t sec = get<int64_t>(p);
+	int64_t nsec = get<int64_t>(p);
+	get<uint64_t>(p);
+	if (get<uint64_t>(p) != context) return 0;
+	buf.st_size = filesize;
+	buf.st_mtim.tv_sec = sec;
+	buf.st_mtim.tv_nsec = nsec;
+	return 1;
+}
+
+// entries
+
+void Snapshot::restore(Route *r, const char *e)
+{	/* rebuild a Route's waypoints, segments & Datachecks from entry e,
+	as read_wpt would have from the .wpt file */
+	const char *p = e + mtime_offset + 2*sizeof(int64_t) + 2*sizeof(uint64_t);
+	get_str(p);
+	uint32_t points = get<uint32_t>(p);
+	r->point_list.reserve(points);
+	r->lat.reserve(points);
+	r->lng.reserve(points);
+	for (uint32_t i = 0; i < points; i++)
+	{	double lat = get<double>(p);
+		double lng = get<double>(p);
+		uint32_t alts = get<uint32_t>(p);
+		r->point_list.push_back(new Waypoint(r, lat, lng, get_str(p), alts));
+					// deleted on termination of program
+	}
+	for (uint32_t i = 1; i < points; i++)
+		r->segment_list.push_back(new HighwaySegment(r->point_list[i-1], r->point_list[i], r, get<double>(p)));
+					  // deleted on termination of program
+	for (uint32_t d = get<uint32_t>(p); d; d--)
+	{	Datacheck::Code code = (Datacheck::Code)get<unsigned char>(p);
+		const char *l1 = get_str(p);
+		const char *l2 = get_str(p);
+		const char *l3 = get_str(p);
+		Datacheck::add(r, l1, l2, l3, code, get_str(p));
+	}
+}
+
+std::string Snapshot::entry(Route *r, std::string &path, struct stat &buf, uint64_t hash, uint64_t context, size_t first_dc)
+{	/* serialize a Route that read_wpt just parsed from path; its
+	Datachecks are those in this thread's buffer from first_dc on */
+	std::string s;
+	put<uint32_t>(s, 0);
+	put<uint64_t>(s, buf.st_size);
+	put<int64_t>(s, buf.st_mtim.tv_sec);
+	put<int64_t>(s, buf.st_mtim.tv_nsec);
+	put<uint64_t>(s, hash);
+	put<uint64_t>(s, context);
+	put_str(s, path.data(), path.size());
+	put<uint32_t>(s, r->point_list.size());
+	for (Waypoint *w : r->point_list)
+	{	put<double>(s, w->lat());
+		put<double>(s, w->lng());
+		put<uint32_t>(s, w->alt_count);
+		put_str(s, w->label, w->labels_size()-1);
+	}
+	for (HighwaySegment *h : r->segment_list) put<double>(s, h->length);
+	std::vector<Datacheck> &dcs = Datacheck::thread_buffer();
+	put<uint32_t>(s, dcs.size()-first_dc);
+	for (size_t d = first_dc; d < dcs.size(); d++)
+	{	put<unsigned char>(s, dcs[d].code);
+		put_str(s, dcs[d].label1);
+		put_str(s, dcs[d].label2);
+		put_str(s, dcs[d].label3);
+		put_str(s, dcs[d].info);
+	}
+	uint32_t len = s.size();
+	memcpy(&s[0], &len, sizeof(len));
+	return s;
+}
+
+std::string Snapshot::touch(const char *e, struct stat &buf)
+{	/* copy of entry e, with a file's current mtime */
+	uint32_t len;
+	memcpy(&len, e, sizeof(len));
+	std::string s(e, len);
+	int64_t mtime[2] = {buf.st_mtim.tv_sec, buf.st_mtim.tv_nsec};
+	memcpy(&s[mtime_offset], mtime, sizeof(mtime));
+	return s;
+}
@@ -0,0 +1,67 @@
+class ErrorList;
+class Route;
+struct stat;
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+class Snapshot
+{   /* A binary snapshot of every Route's parsed .wpt data: its
+    waypoints, segment lengths and the Datachecks read_wpt flagged.
+    It's written after all .wpt files are loaded, and mmapped on the
+    next run so unchanged files needn't be parsed again.
+
+    Each entry is keyed by its .wpt file's path (relative to hwy_data),
+    size, mtime and content hash, plus a hash of the .csv fields that
+    read_wpt's datachecks depend on. If size & mtime match, the file
+    isn't even read; if only the mtime changed (as after a fresh
+    checkout), a matching content hash still lets the entry be reused.
+    Anything else is parsed from text as usual.
+
+    In incremental mode, the caller lists which files have changed
+    since the snapshot was written, and any other .wpt file with an
+    entry is taken from it without being opened at all.
+
+    Strings are stored NUL-terminated, and the file stays mapped until
+    the program ends, so restored Waypoints' labels & Datachecks point
+    straight into it.
+
+    Entry layout, all in native byte order; str = u32 length, bytes, NUL:
+	u32 entry length	u64 file size
+	i64 mtime seconds	i64 mtime nanoseconds
+	u64 content hash	u64 context hash
+	str path
+	u32 point count, then per point: f64 lat, f64 lng,
+	    u32 alt label count, str labels: the primary label & alt labels,
+	    each NUL-terminated, back to back
+	f64 segment lengths, one fewer than the points
+	u32 Datacheck count, then per Datacheck: u8 code,
+	    str label1, str label2, str label3, str info
+    */
+	static char *data;
+	static size_t size;
+	static std::unordered_map<std::string, const char*> entries;	// path -> entry
+
+	public:
+	static const uint32_t version;
+	static bool enabled;
+	static bool incremental;
+	static std::unordered_set<std::string> changed;	// listed files, relative to hwy_data
+
+	static size_t load(std::string);
+	static bool write(std::string);
+	static const char* find(std::string &);
+	static uint64_t file_size(std::string &);
+	static bool holds(const char *);
+	static size_t list_changed(std::list<std::string> &, std::string &, std::string &, ErrorList &);
+	static bool trust(const char *, std::string &, uint64_t, struct stat &);
+	static uint64_t hash(const char *, size_t);
+	static uint64_t context(Route *, bool);
+	static bool current(const char *, struct stat &, uint64_t);
+	static bool same_content(const char *, size_t, uint64_t, uint64_t);
+	static void restore(Route *, const char *);
+	static std::string entry(Route *, std::string &, struct stat &, uint64_t, uint64_t, size_t);
+	static std::string touch(const char *, struct stat &);
+};
@@ -0,0 +1,81 @@
+#include "Trace.h"
+#include <chrono>
+#include <cstdio>
+
+std::vector<Trace::Lane*> Trace::lanes, Trace::idle;
+std::mutex Trace::mtx;
+static const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+Trace::Holder::Holder()
+{	mtx.lock();
+	if (idle.size())
+	{	lane = idle.back();
+		idle.pop_back();
+	}
+	else {	lane = new Lane;
+		lane->count = 0;
+		lanes.push_back(lane);
+	     }
+	mtx.unlock();
+}
+
+Trace::Holder::~Holder()
+{	mtx.lock();
+	idle.push_back(lane);
+	mtx.unlock();
+}
+
+uint64_t Trace::now()
+{	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now() - start_time).count();
+}
+
+void Trace::record(const char *name, const char *detail, uint64_t begin, uint64_t end)
+{	/* add a span to this thread's lane */
+	static thread_local Holder holder;
+	Lane *l = holder.lane;
+	uint64_t c = l->count.load(std::memory_order_relaxed);
+	l->events[c & (Lane::capacity-1)] = Event{name, detail, begin, end};
+	l->count.store(c+1, std::memory_order_release);
+}
+
+static void put_json_str(FILE *f, const char *s)
+{	fputc('"', f);
+	for (; *s; s++)
+	  if (*s == '"' || *s == '\\')	fprintf(f, "\\%c", *s);
+	  else if ((unsigned char)*s < 0x20)	fprintf(f, "\\u%04x", *s);
+	  else					fputc(*s, f);
+	fputc('"', f);
+}
+
+bool Trace::write(std::string filename)
+{	/* write every lane's spans to filename as Chrome trace JSON.
+	Not safe while other threads are recording. */
+	FILE *f = fopen(filename.data(), "w");
+	if (!f) return 0;
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+	const char *sep = "";
+	for (size_t t = 0; t < lanes.size(); t++)
+	{	uint64_t count = lanes[t]->count.load(std::memory_order_acquire);
+		uint64_t first = count > Lane::capacity ? count - Lane::capacity : 0;
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"lane %zu",
+			sep, t, t);
+		if (first) fprintf(f, " (%llu oldest spans dropped)", (unsigned long long)first);
+		fputs("\"}}", f);
+		sep = ",\n";
+		for (uint64_t i = first; i < count; i++)
+		{	Event &e = lanes[t]->events[i & (Lane::capacity-1)];
+			fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f",
+				e.name, t, e.begin/1000.0, (e.end-e.begin)/1000.0);
+			if (e.detail)
+			{	fputs(",\"args\":{\"detail\":", f);
+				put_json_str(f, e.detail);
+				fputc('}', f);
+			}
+			fputc('}', f);
+		}
+	}
+	fputs("\n]}\n", f);
+	bool ok = !ferror(f);
+	return !fclose(f) && ok;
+}
@@ -0,0 +1,61 @@
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Trace
+{	/* Timed spans of work, exported as Chrome trace JSON (for
+	chrome://tracing or Perfetto) to see how busy each thread was.
+
+	Only compiled in with -D tracing_enabled (make TRACE=1, after a
+	make clean); otherwise TRACE & TRACE_SPAN expand to nothing.
+
+	Each thread records into its own Lane: a fixed-size ring of
+	Events that only that thread writes, so recording takes no lock.
+	If a lane fills up, its oldest events are overwritten. A thread
+	takes a lane on its first span and hands it back when it exits,
+	for the next thread to continue; one lane is one row of the trace.
+	Names & details aren't copied, and must outlive the call to write.
+	*/
+	struct Event
+	{	const char *name;
+		const char *detail;	// or 0
+		uint64_t begin, end;	// nanoseconds since start
+	};
+	struct Lane
+	{	static const size_t capacity = 1 << 16;	// a power of 2
+		Event events[capacity];
+		std::atomic<uint64_t> count;	// ever recorded, including overwritten
+	};
+	struct Holder
+	{	Lane *lane;
+		Holder();
+		~Holder();
+	};
+	static std::vector<Lane*> lanes, idle;
+	static std::mutex mtx;		// for locking lanes & idle when a thread takes or returns a lane
+
+	public:
+	class Span
+	{	const char *name, *detail;
+		uint64_t begin;
+		public:
+		Span(const char *n, const char *d): name(n), detail(d), begin(now()) {}
+		~Span() {record(name, detail, begin, now());}
+	};
+
+	static uint64_t now();
+	static void record(const char *, const char *, uint64_t, uint64_t);
+	static bool write(std::string);
+};
+
+#ifdef tracing_enabled
+  #define TRACE(WHAT) WHAT
+  #define TRACE_CAT(A, B) A##B
+  #define TRACE_VAR(LINE) TRACE_CAT(trace_span_, LINE)
+  #define TRACE_SPAN(NAME, DETAIL) Trace::Span TRACE_VAR(__LINE__)(NAME, DETAIL)
+#else
+  #define TRACE(WHAT)
+  #define TRACE_SPAN(NAME, DETAIL)
+#endif
@@ -1,3 +1,203 @@
 #include "TravelerList.h"
+#include "../Args/Args.h"
+#include "../ConnectedRoute/ConnectedRoute.h"
+#include "../ErrorList/ErrorList.h"
+#include "../HighwaySegment/HighwaySegment.h"
+#include "../HighwaySystem/HighwaySystem.h"
+#include "../Metrics/Metrics.h"
+#include "../NameTable/NameTable.h"
+#include "../Route/Route.h"
+#include "../../functions/upper.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 std::mutex TravelerList::mtx;
 std::list<std::string> TravelerList::ids;
+std::vector<TravelerList*> TravelerList::allusers;
+
+TravelerList::TravelerList(std::string &travelername, ErrorList *el)
+{	/* read & process travelername (a .list file's name) from the user list path */
+	update = 0;
+	lines = 0;
+	segments = 0;
+	traveler_name = travelername.substr(0, travelername.size()-5); // strip ".list"
+	std::string filename = Args::userlistfilepath + "/" + travelername;
+	int fd = open(filename.data(), O_RDONLY);
+	if (fd < 0)
+	{	el->add_error("Could not open " + filename);
+		return;
+	}
+	struct stat buf;
+	if (fstat(fd, &buf))
+	{	el->add_error("Could not stat " + filename);
+		close(fd);
+		return;
+	}
+	Metrics::count(Metrics::FILES, 1);
+	Metrics::count(Metrics::BYTES, buf.st_size);
+	// map the file read-only and parse straight from the mapping
+	if (buf.st_size)
+	{	char *listdata = (char*)mmap(0, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (listdata == MAP_FAILED)
+		{	el->add_error("Could not map " + filename + " into memory");
+			close(fd);
+			return;
+		}
+		madvise(listdata, buf.st_size, MADV_SEQUENTIAL);
+		parse(listdata, listdata+buf.st_size);
+		munmap(listdata, buf.st_size);
+	}
+	close(fd);
+	mark_spans();
+
+	log += "Processed " + std::to_string(lines) + " good lines marking "
+	     + std::to_string(segments) + " segments traveled.\n";
+	FILE *f = fopen((Args::logfilepath+"/users/"+traveler_name+".log").data(), "w");
+	if (f)
+	{	fwrite(log.data(), 1, log.size(), f);
+		fclose(f);
+	}
+	log.clear();
+	log.shrink_to_fit();
+}
+
+void TravelerList::parse(const char *c, const char *end)
+{	/* tokenize each line in place & mark the segments it names */
+	Field f[7];
+	// skip a UTF-8 BOM
+	if (end-c >= 3 && !memcmp(c, "\xEF\xBB\xBF", 3)) c += 3;
+	const char *eol;
+	for (; c < end; c = eol)
+	{	// find end of line, and the start of the next
+		for (eol = c; eol < end && *eol != '\n' && *eol != '\r'; eol++);
+		const char *line_end = eol;
+		while (eol < end && (*eol == '\n' || *eol == '\r')) eol++;
+		// drop any comment
+		if (const char *hash = (const char*)memchr(c, '#', line_end-c)) line_end = hash;
+		// split on whitespace; a 7th field just means too many
+		size_t n = 0;
+		const char *last = c;	// end of the last field
+		for (const char *t = c;;)
+		{	while (t < line_end && (*t == ' ' || *t == '\t')) t++;
+			if (t == line_end) break;
+			const char *s = t;
+			while (t < line_end && *t != ' ' && *t != '\t') t++;
+			if (n < 7) f[n] = Field{s, size_t(t-s)};
+			n++;
+			last = t;
+		}
+		if (!n) continue;
+		line = Field{f[0].str, size_t(last-f[0].str)};
+		if (n != 4 && n != 6)
+		{	note(("Incorrect format line (4 or 6 fields expected, found " + std::to_string(n) + ")").data());
+			continue;
+		}
+
+		// look up the route(s)
+		Route *r1 = find_route(f[0], f[1]);
+		if (!r1) continue;
+		Route *r2 = n == 4 ? r1 : find_route(f[3], f[4]);
+		if (!r2) continue;
+		if (!r1->system->active_or_preview())
+		{	note("Ignoring line matching highway in system in development");
+			continue;
+		}
+		if (r1 != r2 && (!r1->con_route || r1->con_route != r2->con_route))
+		{	note("Routes not in the same connected route");
+			continue;
+		}
+
+		// look up the waypoints
+		Field &l2 = f[n == 4 ? 3 : 5];
+		unsigned int i1 = r1->find_label(f[2].str, f[2].len);
+		unsigned int i2 = r2->find_label(l2.str, l2.len);
+		if (i1 == (unsigned int)-1 || i2 == (unsigned int)-1)
+		{	note("Waypoint label(s) not found");
+			continue;
+		}
+		if (r1 == r2 && i1 == i2)
+		{	note("Equivalent waypoint labels mark zero distance traveled");
+			continue;
+		}
+
+		// mark the segments between them
+		if (r1 == r2) clinch(r1, i1, i2);
+		else {	if (r1->rootOrder > r2->rootOrder)
+			{	std::swap(r1, r2);
+				std::swap(i1, i2);
+			}
+			// from the first point to where r1 meets the next chopped route,
+			// through every chopped route in between, then on to the second
+			clinch(r1, i1, r1->is_reversed ? 0 : r1->segment_list.size());
+			std::vector<Route*> &roots = r1->con_route->roots;
+			for (int o = r1->rootOrder+1; o < r2->rootOrder; o++)
+				clinch(roots[o], 0, roots[o]->segment_list.size());
+			clinch(r2, r2->is_reversed ? r2->segment_list.size() : 0, i2);
+		     }
+		lines++;
+	}
+}
+
+void TravelerList::note(const char *message)
+{	// log a message about the line being processed
+	log += message;
+	log += " in line: ";
+	log.append(line.str, line.len);
+	log += '\n';
+}
+
+Route* TravelerList::find_route(Field &rg, Field &rte)
+{	/* the Route a .list file's region & route name fields refer to, or 0 */
+	static thread_local std::string key;
+	key.assign(rg.str, rg.len);
+	key += ' ';
+	key.append(rte.str, rte.len);
+	if (Route *r = Route::pri_list_hash.find(key)) return r;
+	if (Route *r = Route::alt_list_hash.find(key))
+	{	note(("Note: deprecated route name " + key + " -> canonical name " + r->readable_name()).data());
+		upper(key.data());
+		r->system->uarn_mtx.lock();
+		r->system->unusedaltroutenames.erase(key);
+		r->system->uarn_mtx.unlock();
+		return r;
+	}
+	note("Unknown region/highway combo");
+	return 0;
+}
+
+void TravelerList::clinch(Route *r, unsigned int beg, unsigned int end)
+{	// note r's segments between points beg & end as traveled
+	if (beg > end) std::swap(beg, end);
+	if (beg < end) spans.push_back(Span{r, beg, end});
+}
+
+void TravelerList::mark_spans()
+{	/* merge overlapping spans, so each segment is marked once, and
+	mark them, locking each segment only to add this traveler to it */
+	std::sort(spans.begin(), spans.end(), [](const Span &a, const Span &b)
+		{return a.route->index != b.route->index ? a.route->index < b.route->index : a.beg < b.beg;});
+	size_t m = 0;
+	for (size_t i = 1; i < spans.size(); i++)
+	  if (spans[i].route == spans[m].route && spans[i].beg <= spans[m].end)
+		spans[m].end = std::max(spans[m].end, spans[i].end);
+	  else	spans[++m] = spans[i];
+	if (spans.size()) spans.resize(m+1);
+	for (Span &s : spans) segments += s.end - s.beg;
+	clinched_segments.reserve(segments);
+	for (Span &s : spans)
+	{	routes.insert(s.route);
+		for (unsigned int i = s.beg; i < s.end; i++)
+		{	HighwaySegment *h = s.route->segment_list[i];
+			clinched_segments.push_back(h);
+			h->clin_mtx.lock();
+			h->clinched_by.push_back(this);
+			h->clin_mtx.unlock();
+		}
+	}
+	std::vector<Span>().swap(spans);
+}
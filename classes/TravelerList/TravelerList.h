@@ -1,18 +1,70 @@
+class ErrorList;
 class HighwaySegment;
 class HighwaySystem;
 class Region;
 class Route;
 #include <list>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 class TravelerList
-{
+{   /* This class encapsulates the contents of one .list file
+    that represents the travels of one individual user.
+
+    A list file consists of lines of 4 values:
+    region route_name start_waypoint end_waypoint
+
+    which indicates that the user has traveled the highway names
+    route_name in the given region between the waypoints named
+    start_waypoint end_waypoint, or lines of 6 values:
+    region1 route_name1 waypoint1 region2 route_name2 waypoint2
+
+    for travels spanning two chopped routes of the same connected
+    route, taking in all of every chopped route between them.
+    Anything after a # is a comment.
+
+    Each line's travels are noted as spans of point indices. Once the
+    whole file is read, overlapping spans are merged, and only then are
+    segments marked, so a segment traveled on many lines is marked once.
+
+    The file is mapped read-only and tokenized in place: each field
+    is a pointer & length into the mapping, and route names are looked
+    up through Route's NameTables without being copied out. One
+    TravelerList is made per file, by any thread; what it shares with
+    others (segments' clinched_by, Routes' label sets) is locked per
+    segment or Route. Problems with the file go to its own log,
+    users/<traveler_name>.log.
+    */
+	struct Field
+	{	const char *str;
+		size_t len;
+	};
+	struct Span
+	{	Route *route;
+		unsigned int beg, end;	// point_list indices
+	};
+	std::vector<Span> spans;	// traveled, as read; merged by mark_spans
+	std::string log;
+	Field line;			// the line being processed, for the log
+	size_t lines, segments;		// good lines & segments clinched, for the log
+
+	void parse(const char *, const char *);
+	void note(const char *);
+	Route* find_route(Field &, Field &);
+	void clinch(Route *, unsigned int, unsigned int);
+	void mark_spans();
+
 	public:
-	std::unordered_set<HighwaySegment*> clinched_segments;
+	std::string traveler_name;
+	std::vector<HighwaySegment*> clinched_segments;	// each segment once, in route & point order
 	std::string *update;
 	std::unordered_set<Route*> routes;
 	static std::mutex mtx;
 	static std::list<std::string> ids;
+	static std::vector<TravelerList*> allusers;
+
+	TravelerList(std::string &, ErrorList *);
 };
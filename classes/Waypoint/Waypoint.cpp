@@ -1,84 +1,138 @@
 #include "Waypoint.h"
+#include "../Arena/Arena.h"
+#include "../Colocation/Colocation.h"
 #include "../Datacheck/Datacheck.h"
-#include "../DBFieldLength/DBFieldLength.h"
 #include "../HighwaySystem/HighwaySystem.h"
 #include "../Route/Route.h"
-#include "../../functions/valid_num_str.h"
+#include "../../functions/parse_coord.h"
 #include <cmath>
 #include <cstring>
 
 #define pi 3.141592653589793238
 
-Waypoint::Waypoint(char *line, Route *rte)
-{	/* initialize object from a .wpt file line */
+static void malformed_arg(Waypoint *w, Datacheck::Code code, const char *arg, const char *end)
+{	// flag the URL argument at arg, up to the next '&' or end, truncated to fit
+	const char *amp = (const char*)memchr(arg, '&', end-arg);
+	if (amp) end = amp;
+	std::string info(arg, end);
+	if (info.size() > DBFieldLength::dcErrValue)
+	{	info = info.substr(0, DBFieldLength::dcErrValue-3);
+		while (info.back() < 0)	info.erase(info.end()-1);
+		info += "...";
+	}
+	Datacheck::add(w->route, w->label, "", "", code, info.data());
+}
+
+Waypoint::Waypoint(const char *line, const char *end, Route *rte)
+{	/* initialize object from a .wpt file line, [line, end)
+	with leading & trailing whitespace already stripped */
 	route = rte;
 
 	// parse WPT line
-	size_t spn = 0;
-	for (char* c = line; *c; c += spn)
-	{	for (spn = strcspn(c, " "); c[spn] == ' '; spn++) c[spn] = 0;
-		alt_labels.emplace_back(c);
-	}
-
-	// We know alt_labels will have at least one element, because if the WPT line is
-	// blank or contains only spaces, Route::read_wpt will not call this constructor.
-	std::string URL = alt_labels.back();	// last token is actually the URL...
-	alt_labels.pop_back();			// ...and not a label.
-	if (alt_labels.empty()) label = "NULL";
-	else {	label = alt_labels.front();	// first token is the primary label...
-		alt_labels.pop_front();		// ...and not an alternate.
-	     }
-	is_hidden = label[0] == '+';
-	colocated = 0;
-
-	// parse URL
-	size_t latBeg = URL.find("lat=")+4;
-	size_t lonBeg = URL.find("lon=")+4;
-	if (latBeg == 3 || lonBeg == 3)
-	{	Datacheck::add(route, label, "", "", "MALFORMED_URL", "MISSING_ARG(S)");
-		lat = 0;	lng = 0;	return;
+	// We know there's at least one token, because if the WPT line is blank
+	// or contains only spaces, Route::read_wpt will not call this constructor.
+	const char *URL = end;			// last token is actually the URL...
+	while (URL > line && URL[-1] != ' ') URL--;
+	// ...and the rest are labels, first the primary label, then alternates.
+	// Count them & their size, then copy them into the Arena back to back.
+	size_t tokens = 0, size = 0;
+	for (const char *c = line; c < URL; tokens++)
+	{	const char *spc = (const char*)memchr(c, ' ', URL-c);
+		if (!spc) spc = URL;
+		size += spc-c+1;
+		for (c = spc; c < URL && *c == ' '; c++);
 	}
-	bool valid_coords = 1;
-	if (!valid_num_str(URL.data()+latBeg, '&'))
-	{	size_t ampersand = URL.find('&', latBeg);
-		std::string lat_string = (ampersand == -1) ? URL.data()+latBeg : URL.substr(latBeg, ampersand-latBeg);
-		if (lat_string.size() > DBFieldLength::dcErrValue)
-		{	lat_string = lat_string.substr(0, DBFieldLength::dcErrValue-3);
-			while (lat_string.back() < 0)	lat_string.erase(lat_string.end()-1);
-			lat_string += "...";
-		}
-		Datacheck::add(route, label, "", "", "MALFORMED_LAT", lat_string);
-		valid_coords = 0;
+	if (!tokens)
+	{	label = "NULL";
+		alt_count = 0;
 	}
-	if (!valid_num_str(URL.data()+lonBeg, '&'))
-	{	size_t ampersand = URL.find('&', lonBeg);
-		std::string lng_string = (ampersand == -1) ? URL.data()+lonBeg : URL.substr(lonBeg, ampersand-lonBeg);
-		if (lng_string.size() > DBFieldLength::dcErrValue)
-		{	lng_string = lng_string.substr(0, DBFieldLength::dcErrValue-3);
-			while (lng_string.back() < 0)	lng_string.erase(lng_string.end()-1);
-			lng_string += "...";
+	else {	char *dest = (char*)Arena::allocate(size);
+		label = dest;
+		alt_count = tokens-1 < 0xFFFF ? tokens-1 : 0xFFFF;
+		for (const char *c = line; c < URL;)
+		{	const char *spc = (const char*)memchr(c, ' ', URL-c);
+			if (!spc) spc = URL;
+			memcpy(dest, c, spc-c);
+			dest += spc-c;
+			*dest++ = 0;
+			for (c = spc; c < URL && *c == ' '; c++);
 		}
-		Datacheck::add(route, label, "", "", "MALFORMED_LON", lng_string);
-		valid_coords = 0;
+	     }
+	is_hidden = label[0] == '+';
+	point_num = route->lat.size();
+
+	// parse URL, finding the first "lat=" & "lon=" in one pass
+	const char *latBeg = 0, *lonBeg = 0;
+	for (const char *c = URL; c+4 <= end && !(latBeg && lonBeg); c++)
+	  if (c[0] == 'l' && c[3] == '=')
+	  {	if	(c[1] == 'a' && c[2] == 't' && !latBeg) latBeg = c+4;
+		else if (c[1] == 'o' && c[2] == 'n' && !lonBeg) lonBeg = c+4;
+	  }
+	if (!latBeg || !lonBeg)
+	{	Datacheck::add(route, label, "", "", Datacheck::MALFORMED_URL, "MISSING_ARG(S)");
+		route->lat.push_back(0);
+		route->lng.push_back(0);
+		return;
 	}
-	if (valid_coords)
-	     {	lat = strtod(&URL[latBeg], 0);
-		lng = strtod(&URL[lonBeg], 0);
+	double lat, lng;
+	bool valid_lat = parse_coord(latBeg, end, lat);
+	bool valid_lng = parse_coord(lonBeg, end, lng);
+	if (!valid_lat) malformed_arg(this, Datacheck::MALFORMED_LAT, latBeg, end);
+	if (!valid_lng) malformed_arg(this, Datacheck::MALFORMED_LON, lonBeg, end);
+	if (valid_lat && valid_lng)
+	     {	route->lat.push_back(lat);
+		route->lng.push_back(lng);
 	     }
-	else {	lat = 0;
-		lng = 0;
+	else {	route->lat.push_back(0);
+		route->lng.push_back(0);
 	     }
 }
 
+Waypoint::Waypoint(Route *rte, double lat, double lng, const char *labels, unsigned short alts)
+{	/* initialize object from a Snapshot entry, whose labels are
+	already stored back to back, & stay mapped till the program ends */
+	route = rte;
+	label = labels;
+	alt_count = alts;
+	is_hidden = label[0] == '+';
+	point_num = route->lat.size();
+	route->lat.push_back(lat);
+	route->lng.push_back(lng);
+}
+
+Waypoint::AltLabels Waypoint::alt_labels()
+{	return AltLabels(label+strlen(label)+1, alt_count);
+}
+
+size_t Waypoint::labels_size()
+{	/* bytes taken by the labels, NULs included */
+	const char *end = label+strlen(label)+1;
+	for (unsigned short a = 0; a < alt_count; a++) end += strlen(end)+1;
+	return end-label;
+}
+
+Colocation *Waypoint::colocated()
+{	/* the points at this location, or 0 if this is the only one */
+	return Colocation::find(lat(), lng());
+}
+
+double Waypoint::lat()
+{	return route->lat[point_num];
+}
+
+double Waypoint::lng()
+{	return route->lng[point_num];
+}
+
 std::string Waypoint::str()
 {	std::string ans = route->root + " " + label;
 	char coordstr[51];
-	sprintf(coordstr, "%.15g", lat);
+	sprintf(coordstr, "%.15g", lat());
 	if (!strchr(coordstr, '.')) strcat(coordstr, ".0"); // add single trailing zero to ints for compatibility with Python
 	ans += " (";
 	ans += coordstr;
 	ans += ',';
-	sprintf(coordstr, "%.15g", lng);
+	sprintf(coordstr, "%.15g", lng());
 	if (!strchr(coordstr, '.')) strcat(coordstr, ".0"); // add single trailing zero to ints for compatibility with Python
 	ans += coordstr;
 	return ans + ')';
@@ -87,18 +141,22 @@ std::string Waypoint::str()
 bool Waypoint::same_coords(Waypoint *other)
 {	/* return if this waypoint is colocated with the other,
 	using exact lat,lng match */
-	return lat == other->lat && lng == other->lng;
+	return lat() == other->lat() && lng() == other->lng();
 }
 
 double Waypoint::distance_to(Waypoint *other)
-{	/* return the distance in miles between this waypoint and another
+{	return distance(lat(), lng(), other->lat(), other->lng());
+}
+
+double Waypoint::distance(double lat1, double lng1, double lat2, double lng2)
+{	/* return the distance in miles between two coordinate pairs
 	including the factor defined by the CHM project to adjust for
 	unplotted curves in routes */
 	// convert to radians
-	double rlat1 = lat * (pi/180);
-	double rlng1 = lng * (pi/180);
-	double rlat2 = other->lat * (pi/180);
-	double rlng2 = other->lng * (pi/180);
+	double rlat1 = lat1 * (pi/180);
+	double rlng1 = lng1 * (pi/180);
+	double rlat2 = lat2 * (pi/180);
+	double rlng2 = lng2 * (pi/180);
 
 	// haversine formula
 	double ans = asin(sqrt(pow(sin((rlat2-rlat1)/2),2) + cos(rlat1) * cos(rlat2) * pow(sin((rlng2-rlng1)/2),2))) * 7926.2; /* EARTH_DIAMETER */
@@ -107,15 +165,19 @@ double Waypoint::distance_to(Waypoint *other)
 }
 
 double Waypoint::angle(Waypoint *pred, Waypoint *succ)
-{	/* return the angle in degrees formed by the waypoints between the
-	line from pred to self and self to succ */
+{	return angle(pred->lat(), pred->lng(), lat(), lng(), succ->lat(), succ->lng());
+}
+
+double Waypoint::angle(double latpred, double lngpred, double latself, double lngself, double latsucc, double lngsucc)
+{	/* return the angle in degrees formed by three coordinate pairs
+	between the line from pred to self and self to succ */
 	// convert to radians
-	double rlatself = lat * (pi/180);
-	double rlngself = lng * (pi/180);
-	double rlatpred = pred->lat * (pi/180);
-	double rlngpred = pred->lng * (pi/180);
-	double rlatsucc = succ->lat * (pi/180);
-	double rlngsucc = succ->lng * (pi/180);
+	double rlatself = latself * (pi/180);
+	double rlngself = lngself * (pi/180);
+	double rlatpred = latpred * (pi/180);
+	double rlngpred = lngpred * (pi/180);
+	double rlatsucc = latsucc * (pi/180);
+	double rlngsucc = lngsucc * (pi/180);
 
 	double x0 = cos(rlngpred)*cos(rlatpred);
 	double x1 = cos(rlngself)*cos(rlatself);
@@ -140,61 +202,11 @@ double Waypoint::angle(Waypoint *pred, Waypoint *succ)
 
 /* Datacheck */
 
-void Waypoint::distance_update(char *fstr, double &vis_dist, Waypoint *prev_w)
-{	// visible distance update, and last segment length check
-	double last_distance = distance_to(prev_w);
-	vis_dist += last_distance;
-	if (last_distance > 20)
-	{	sprintf(fstr, "%.2f", last_distance);
-		Datacheck::add(route, prev_w->label, label, "", "LONG_SEGMENT", fstr);
-	}
-}
-
-void Waypoint::duplicate_coords(std::unordered_set<Waypoint*> &coords_used, char *fstr)
-{	// duplicate coordinates
-	Waypoint *w;
-	if (!colocated) w = this;
-	else w = colocated->front();
-	if (!coords_used.insert(w).second)
-	  for (Waypoint *other_w : route->point_list)
-	  {	if (this == other_w) break;
-		if (lat == other_w->lat && lng == other_w->lng)
-		{	sprintf(fstr, "(%.15g,%.15g)", lat, lng);
-			Datacheck::add(route, other_w->label, label, "", "DUPLICATE_COORDS", fstr);
-		}
-	  }
-}
-
-void Waypoint::label_invalid_char()
-{	// look for labels with invalid characters
-	if (label == "*")
-		  Datacheck::add(route, label, "", "", "LABEL_INVALID_CHAR", "");
-	else for (const char *c = label.data(); *c; c++)
-		if ((*c == 42 || *c == 43) && c > label.data()
-		 || (*c < 40)	|| (*c == 44)	|| (*c > 57 && *c < 65)
-		 || (*c == 96)	|| (*c > 122)	|| (*c > 90 && *c < 95))
-		{	if (!strncmp(label.data(), "\xEF\xBB\xBF", 3))
-				Datacheck::add(route, label, "", "", "LABEL_INVALID_CHAR", "UTF-8 BOM");
-			else	Datacheck::add(route, label, "", "", "LABEL_INVALID_CHAR", "");
-			break;
-		}
-	for (std::string& lbl : alt_labels)
-	  if (lbl == "*")
-		  Datacheck::add(route, lbl, "", "", "LABEL_INVALID_CHAR", "");
-	  else for (const char *c = lbl.data(); *c; c++)
-		if (*c == '+' && c > lbl.data() || *c == '*' && (c > lbl.data()+1 || lbl[0] != '+')
-		 || (*c < 40)	|| (*c == 44)	|| (*c > 57 && *c < 65)
-		 || (*c == 96)	|| (*c > 122)	|| (*c > 90 && *c < 95))
-		{	Datacheck::add(route, lbl, "", "", "LABEL_INVALID_CHAR", "");
-			break;
-		}
-}
-
 bool Waypoint::label_too_long()
 {	// label longer than the DB can store
-	if (label.size() > DBFieldLength::label)
+	if (strlen(label) > DBFieldLength::label)
 	{	// save the excess beyond what can fit in a DB field, to put in the info/value column
-		std::string excess = label.data()+DBFieldLength::label-3;
+		std::string excess = label+DBFieldLength::label-3;
 		// strip any partial multi-byte characters off the beginning
 		while (excess.front() < 0)	excess.erase(excess.begin());
 		// if it's too long for the info/value column,
@@ -207,186 +219,213 @@ bool Waypoint::label_too_long()
 			excess += "...";
 		}
 		// now truncate the label itself
-		label = label.substr(0, DBFieldLength::label-3);
+		std::string truncated(label, DBFieldLength::label-3);
 		// and strip any partial multi-byte characters off the end
-		while (label.back() < 0)	label.erase(label.end()-1);
-		Datacheck::add(route, label+"...", "", "", "LABEL_TOO_LONG", "..."+excess);
+		while (truncated.back() < 0)	truncated.erase(truncated.end()-1);
+		Datacheck::add(route, Datacheck::intern(truncated+"..."), "", "", Datacheck::LABEL_TOO_LONG, ("..."+excess).data());
 		return 1;
 	}
 	return 0;
 }
 
-void Waypoint::out_of_bounds(char *fstr)
-{	// out-of-bounds coords
-	if (lat > 90 || lat < -90 || lng > 180 || lng < -180)
-	{	sprintf(fstr, "(%.15g,%.15g)", lat, lng);
-		Datacheck::add(route, label, "", "", "OUT_OF_BOUNDS", fstr);
+/* label checks */
+
+// character classes for label_datachecks
+enum { INVALID = 1, STAR_PLUS = 2, STRUCTURE = 4 };
+static struct LabelChars
+{	unsigned char cls[256];
+	LabelChars()
+	{	for (int i = 0; i < 256; i++)
+		{	char c = i;
+			cls[i] = (c < 40)  || (c == 44)  || (c > 57 && c < 65)
+			      || (c == 96) || (c > 122) || (c > 90 && c < 95) ? INVALID : 0;
+		}
+		cls['*'] = cls['+'] = STAR_PLUS;
+		cls['/'] = cls['_'] = cls['('] = cls[')'] = STRUCTURE;
+	}
+} label_chars;
+
+Waypoint::LabelContext::LabelContext(Route *r, bool usa_flag)
+{	usa = usa_flag;
+	rte_ban = r->route + r->banner;
+	route_num = 0;
+	if (r->route.size() && r->route.back() >= '0' && r->route.back() <= '9')
+	{	route_num = r->route.data() + r->route.size();
+		while (route_num > r->route.data() && route_num[-1] >= '0' && route_num[-1] <= '9') route_num--;
 	}
 }
 
-/* checks for visible points */
-
-void Waypoint::bus_with_i()
-{	// look for I-xx with Bus instead of BL or BS
-	const char *c = label.data();
+static bool bus_with_i(const char *c)
+{	// I-xx with Bus instead of BL or BS
 	if (*c == '*') c++;
-	if (*c++ != 'I' || *c++ != '-') return;
-	if (*c < '0' || *c > '9') return;
+	if (*c++ != 'I' || *c++ != '-') return 0;
+	if (*c < '0' || *c > '9') return 0;
 	while (*c >= '0' && *c <= '9') c++;
 	if ( *c == 'E' || *c == 'W' || *c == 'C' || *c == 'N' || *c == 'S'
 	  || *c == 'e' || *c == 'w' || *c == 'c' || *c == 'n' || *c == 's' ) c++;
-	if ( (*c == 'B' || *c == 'b')
-	  && (*(c+1) == 'u' || *(c+1) == 'U')
-	  && (*(c+2) == 's' || *(c+2) == 'S') )
-		Datacheck::add(route, label, "", "", "BUS_WITH_I", "");
+	return (*c == 'B' || *c == 'b')
+	    && (*(c+1) == 'u' || *(c+1) == 'U')
+	    && (*(c+2) == 's' || *(c+2) == 'S');
 }
 
-void Waypoint::interstate_no_hyphen()
-{	const char *c = label[0] == '*' ? label.data()+1 : label.data();
+static bool interstate_no_hyphen(const char *c)
+{	if (*c == '*') c++;
 	if (c[0] == 'T' && c[1] == 'o') c += 2;
-	if (c[0] == 'I' && isdigit(c[1]))
-	  Datacheck::add(route, label, "", "", "INTERSTATE_NO_HYPHEN", "");
-}
-
-void Waypoint::label_invalid_ends()
-{	// look for labels with invalid first or final characters
-	const char *c = label.data();
-	while (*c == '*') c++;
-	if (*c == '_' || *c == '/' || *c == '(')
-		Datacheck::add(route, label, "", "", "INVALID_FIRST_CHAR", std::string(1, *c));
-	if (label.back() == '_' || label.back() == '/')
-		Datacheck::add(route, label, "", "", "INVALID_FINAL_CHAR", std::string(1, label.back()));
+	return c[0] == 'I' && c[1] >= '0' && c[1] <= '9';
 }
 
-void Waypoint::label_looks_hidden()
-{	// look for labels that look like hidden waypoints but which aren't hidden
-	if (label.size() != 7)			return;
-	if (label[0] != 'X')			return;
-	if (label[1] < '0' || label[1] > '9')	return;
-	if (label[2] < '0' || label[2] > '9')	return;
-	if (label[3] < '0' || label[3] > '9')	return;
-	if (label[4] < '0' || label[4] > '9')	return;
-	if (label[5] < '0' || label[5] > '9')	return;
-	if (label[6] < '0' || label[6] > '9')	return;
-	Datacheck::add(route, label, "", "", "LABEL_LOOKS_HIDDEN", "");
-}
-
-void Waypoint::label_parens()
-{	// look for parenthesis balance in label
-	int parens = 0;
-	const char *left = 0;
-	const char* right = 0;
-	for (const char *c = label.data(); *c; c++)
-	{	if (*c == '(')
-		     {	if (left)
-			{	Datacheck::add(route, label, "", "", "LABEL_PARENS", "");
-				return;
-			}
-			left = c;
-			parens++;
-		     }
-		else if	(*c == ')')
-		     {	right = c;
-			parens--;
-		     }
-	}
-	if (parens || right < left)
-		Datacheck::add(route, label, "", "", "LABEL_PARENS", "");
+static bool us_letter(const char *c)
+{	// USxxxA but not USxxxAlt, B/Bus/Byp
+	if (*c == '*') c++;
+	if (*c++ != 'U' || *c++ != 'S')	return 0;
+	if (*c    < '0' || *c++  > '9')	return 0;
+	while (*c >= '0' && *c <= '9')	c++;
+	if (*c    < 'A' || *c++  > 'B')	return 0;
+	if (*c == 0 || *c == '/' || *c == '_' || *c == '(') return 1;
+	// is it followed by a city abbrev?
+	return *c >= 'A' && *c++ <= 'Z'
+	    && *c >= 'a' && *c++ <= 'z'
+	    && *c >= 'a' && *c++ <= 'z'
+	    && *c == 0 || *c == '/' || *c == '_' || *c == '(';
 }
 
-void Waypoint::label_selfref(const char *slash)
-{	// looking for the route within the label
-	// partially complete "references own route" -- too many FP
-	// first check for number match after a slash, if there is one
-	if (slash && route->route.back() >= '0' && route->route.back() <= '9')
-	{	int digit_starts = route->route.size()-1;
-		while (digit_starts >= 0 && route->route[digit_starts] >= '0' && route->route[digit_starts] <= '9')
-			digit_starts--;
-		if (!strcmp(slash+1, route->route.data()+digit_starts+1) || !strcmp(slash+1, route->route.data()))
-		     {	Datacheck::add(route, label, "", "", "LABEL_SELFREF", "");
-			return;
-		     }
-		else {	const char *underscore = strchr(slash+1, '_');
-			if (underscore
-			&& (label.substr(slash-label.data()+1, underscore-slash-1) == route->route.data()+digit_starts+1
-			||  label.substr(slash-label.data()+1, underscore-slash-1) == route->route.data()))
-			{	Datacheck::add(route, label, "", "", "LABEL_SELFREF", "");
-				return;
-			}
-		     }
-	}
-	// now the remaining checks
-	std::string rte_ban = route->route + route->banner;
-	const char *l = label.data();
-	const char *rb = rte_ban.data();
-	const char *end = rb+rte_ban.size();
-	while (rb < end)
-	{	if (*l != *rb) return;
-		l++;
-		rb++;
-	}
-	if (*l == 0 || *l == '_' || *l == '/')
-		Datacheck::add(route, label, "", "", "LABEL_SELFREF", "");
+static bool looks_hidden(const char *label, size_t len)
+{	// looks like a hidden waypoint's label
+	if (len != 7 || label[0] != 'X') return 0;
+	for (int i = 1; i < 7; i++)
+	  if (label[i] < '0' || label[i] > '9') return 0;
+	return 1;
 }
 
-void Waypoint::label_slashes(const char *slash)
-{	// look for too many slashes in label
-	if (slash && strchr(slash+1, '/'))
-		Datacheck::add(route, label, "", "", "LABEL_SLASHES", "");
+static bool lacks_generic(const char *c)
+{	// label lacks generic highway type
+	if (*c == '*') c++;
+	return (*c == 'O' || *c == 'o')
+	    && (*(c+1) == 'l' || *(c+1) == 'L')
+	    && (*(c+2) == 'd' || *(c+2) == 'D')
+	    &&  *(c+3) >= '0' && *(c+3) <= '9';
 }
 
-void Waypoint::lacks_generic()
-{	// label lacks generic highway type
-	const char* c = label[0] == '*' ? label.data()+1 : label.data();
-	if ( (*c == 'O' || *c == 'o')
-	  && (*(c+1) == 'l' || *(c+1) == 'L')
-	  && (*(c+2) == 'd' || *(c+2) == 'D')
-	  &&  *(c+3) >= '0' && *(c+3) <= '9')
-		Datacheck::add(route, label, "", "", "LACKS_GENERIC", "");
+static bool same(const char *b, const char *e, const char *str)
+{	// whether [b, e) equals NUL-terminated str
+	size_t len = e-b;
+	return !strncmp(b, str, len) && !str[len];
 }
 
-void Waypoint::underscore_datachecks(const char *slash)
-{	const char *underscore = strchr(label.data(), '_');
+void Waypoint::label_datachecks(LabelContext &lc)
+{	/* every check of a point's labels, from one pass over the primary
+	label that notes where its slashes, underscores & parens are, plus
+	one over each alt label. Checks for visible points only look at the
+	label's start or at what the pass found. */
+	const char *lbl = label;
+	bool invalid = 0, slashes = 0, underscores = 0, two_lefts = 0;
+	const char *slash = 0, *underscore = 0, *slash_underscore = 0, *left = 0, *right = 0;
+	int parens = 0;
+	const char *c;
+	for (c = lbl; *c; c++)
+	  if (unsigned char cls = label_chars.cls[(unsigned char)*c])
+	  {	if (cls & INVALID || cls & STAR_PLUS && c > lbl) invalid = 1;
+		else if (cls & STRUCTURE) switch (*c)
+		{   case '/':	if (slash) slashes = 1;
+				else slash = c;
+				break;
+		    case '_':	if (underscore) underscores = 1;
+				else underscore = c;
+				if (slash && !slash_underscore) slash_underscore = c;
+				break;
+		    case '(':	if (left) two_lefts = 1;
+				else left = c;
+				parens++;
+				break;
+		    case ')':	right = c;
+				parens--;
+		}
+	  }
+	size_t len = c-lbl;
+
+	// labels with invalid characters
+	if (!strcmp(lbl, "*"))
+		Datacheck::add(route, lbl, "", "", Datacheck::LABEL_INVALID_CHAR, "");
+	else if (invalid)
+	{	if (!strncmp(lbl, "\xEF\xBB\xBF", 3))
+			Datacheck::add(route, lbl, "", "", Datacheck::LABEL_INVALID_CHAR, "UTF-8 BOM");
+		else	Datacheck::add(route, lbl, "", "", Datacheck::LABEL_INVALID_CHAR, "");
+	}
+	for (const char *a : alt_labels())
+	  if (!strcmp(a, "*"))
+		Datacheck::add(route, a, "", "", Datacheck::LABEL_INVALID_CHAR, "");
+	  else for (c = a; *c; c++)
+	  {	unsigned char cls = label_chars.cls[(unsigned char)*c];
+		if (cls & INVALID
+		 || *c == '+' && c > a
+		 || *c == '*' && (c > a+1 || a[0] != '+'))
+		{	Datacheck::add(route, a, "", "", Datacheck::LABEL_INVALID_CHAR, "");
+			break;
+		}
+	  }
+	if (is_hidden) return;
+
+	// checks for visible points
+	if (lc.usa && len >= 2)
+	{	if (bus_with_i(lbl))
+			Datacheck::add(route, lbl, "", "", Datacheck::BUS_WITH_I, "");
+		if (interstate_no_hyphen(lbl))
+			Datacheck::add(route, lbl, "", "", Datacheck::INTERSTATE_NO_HYPHEN, "");
+		if (us_letter(lbl))
+			Datacheck::add(route, lbl, "", "", Datacheck::US_LETTER, "");
+	}
+	// invalid first or final characters
+	c = lbl;
+	while (*c == '*') c++;
+	char info[2] = {*c, 0};
+	if (*c == '_' || *c == '/' || *c == '(')
+		Datacheck::add(route, lbl, "", "", Datacheck::INVALID_FIRST_CHAR, info);
+	char back = lbl[len-1];
+	info[0] = back;
+	if (back == '_' || back == '/')
+		Datacheck::add(route, lbl, "", "", Datacheck::INVALID_FINAL_CHAR, info);
+	if (looks_hidden(lbl, len))
+		Datacheck::add(route, lbl, "", "", Datacheck::LABEL_LOOKS_HIDDEN, "");
+	// parenthesis balance
+	if (two_lefts || parens || right < left)
+		Datacheck::add(route, lbl, "", "", Datacheck::LABEL_PARENS, "");
+	// the route within the label; partially complete "references own route" -- too many FP.
+	// first check for number match after a slash, if there is one
+	if (slash && lc.route_num
+	&& (!strcmp(slash+1, lc.route_num) || !strcmp(slash+1, route->route.data())
+	 || slash_underscore && (same(slash+1, slash_underscore, lc.route_num) || same(slash+1, slash_underscore, route->route.data()))))
+		Datacheck::add(route, lbl, "", "", Datacheck::LABEL_SELFREF, "");
+	// then for route & banner at the start
+	else if (len >= lc.rte_ban.size() && !memcmp(lbl, lc.rte_ban.data(), lc.rte_ban.size()))
+	{	char next = lbl[lc.rte_ban.size()];
+		if (next == 0 || next == '_' || next == '/')
+			Datacheck::add(route, lbl, "", "", Datacheck::LABEL_SELFREF, "");
+	}
+	// too many slashes
+	if (slashes)
+		Datacheck::add(route, lbl, "", "", Datacheck::LABEL_SLASHES, "");
+	if (lacks_generic(lbl))
+		Datacheck::add(route, lbl, "", "", Datacheck::LACKS_GENERIC, "");
 	if (underscore)
-	{	// look for too many underscores in label
-		if (strchr(underscore+1, '_'))
-			Datacheck::add(route, label, "", "", "LABEL_UNDERSCORES", "");
-		// look for too many characters after underscore in label
-		if (label.data()+label.size() > underscore+4)
-		    if (label.back() > 'Z' || label.back() < 'A' || label.data()+label.size() > underscore+5)
-			Datacheck::add(route, label, "", "", "LONG_UNDERSCORE", "");
-		// look for labels with a slash after an underscore
+	{	// too many underscores
+		if (underscores)
+			Datacheck::add(route, lbl, "", "", Datacheck::LABEL_UNDERSCORES, "");
+		// too many characters after underscore
+		if (lbl+len > underscore+4)
+		    if (back > 'Z' || back < 'A' || lbl+len > underscore+5)
+			Datacheck::add(route, lbl, "", "", Datacheck::LONG_UNDERSCORE, "");
+		// a slash after an underscore
 		if (slash > underscore)
-			Datacheck::add(route, label, "", "", "NONTERMINAL_UNDERSCORE", "");
+			Datacheck::add(route, lbl, "", "", Datacheck::NONTERMINAL_UNDERSCORE, "");
 	}
 }
 
-void Waypoint::us_letter()
-{	// look for USxxxA but not USxxxAlt, B/Bus/Byp
-	const char* c = label[0] == '*' ? label.data()+1 : label.data();
-	if (*c++ != 'U' || *c++ != 'S')	return;
-	if (*c    < '0' || *c++  > '9')	return;
-	while (*c >= '0' && *c <= '9')	c++;
-	if (*c    < 'A' || *c++  > 'B')	return;
-	if (*c == 0 || *c == '/' || *c == '_' || *c == '(')
-		Datacheck::add(route, label, "", "", "US_LETTER", "");
-	// is it followed by a city abbrev?
-	else if (*c >= 'A' && *c++ <= 'Z'
-	      && *c >= 'a' && *c++ <= 'z'
-	      && *c >= 'a' && *c++ <= 'z'
-	      && *c == 0 || *c == '/' || *c == '_' || *c == '(')
-		Datacheck::add(route, label, "", "", "US_LETTER", "");
+void* Waypoint::operator new(size_t size)
+{	return Arena::allocate(size);
 }
 
-void Waypoint::visible_distance(char *fstr, double &vis_dist, Waypoint *&last_visible)
-{	// complete visible distance check, omit report for active
-	// systems to reduce clutter
-	if (vis_dist > 10 && !route->system->active())
-	{	sprintf(fstr, "%.2f", vis_dist);
-		Datacheck::add(route, last_visible->label, label, "", "VISIBLE_DISTANCE", fstr);
-	}
-	last_visible = this;
-	vis_dist = 0;
+void Waypoint::operator delete(void* p, size_t size)
+{	Arena::deallocate(p, size);
 }
 
 #undef pi
@@ -1,11 +1,7 @@
-class HGVertex;
+class Colocation;
 class Route;
-#include <deque>
-#include <forward_list>
-#include <fstream>
-#include <list>
-#include <unordered_set>
-#include <vector>
+#include <cstring>
+#include <string>
 
 class Waypoint
 {   /* This class encapsulates the information about a single waypoint
@@ -17,43 +13,66 @@ class Waypoint
 
     root is the unique identifier for the route in which this waypoint
     is defined
+
+    There are millions of these, so they're kept small: coordinates live
+    in the Route's coordinate table, and the labels are NUL-terminated
+    strings stored back to back, primary label first, either in the Arena
+    or in a Snapshot mapping. Data only some points need is kept in side
+    tables rather than here: the points colocated with this one are found
+    by looking its coordinates up in Colocation's tables.
     */
 
 	public:
+	class AltLabels
+	{	// the alt labels following a Waypoint's primary label
+		const char *first;
+		unsigned short count;
+
+		public:
+		struct iterator
+		{	const char *label;
+			unsigned short left;
+			const char *operator * ()		{return label;}
+			iterator &operator ++ ()		{label += strlen(label)+1; left--; return *this;}
+			bool operator != (const iterator &other){return left != other.left;}
+		};
+		AltLabels(const char *f, unsigned short c): first(f), count(c) {}
+		iterator begin()	{return iterator{first, count};}
+		iterator end()		{return iterator{0, 0};}
+		unsigned short size()	{return count;}
+	};
+
 	Route *route;
-	std::list<Waypoint*> *colocated;
-	HGVertex *vertex;
-	double lat, lng;
-	std::string label;
-	std::deque<std::string> alt_labels;
-	std::vector<Waypoint*> ap_coloc;
-	std::forward_list<Waypoint*> near_miss_points;
-	unsigned int point_num;
+	const char *label;
+	unsigned int point_num;		// index into the Route's coordinate table
+	unsigned short alt_count;
 	bool is_hidden;
 
-	Waypoint(char *, Route *);
+	Waypoint(const char *, const char *, Route *);
+	Waypoint(Route *, double, double, const char *, unsigned short);
+	static void* operator new(size_t);		// allocated from the calling thread's Arena
+	static void operator delete(void*, size_t);	// reclaimed only if it was the Arena's last allocation
 
+	AltLabels alt_labels();
+	Colocation *colocated();
+	size_t labels_size();
 	std::string str();
+	double lat();
+	double lng();
 	bool same_coords(Waypoint *);
 	double distance_to(Waypoint *);
 	double angle(Waypoint *, Waypoint *);
+	static double distance(double, double, double, double);
+	static double angle(double, double, double, double, double, double);
 
 	// Datacheck
-	void distance_update(char *, double &, Waypoint *);
-	void duplicate_coords(std::unordered_set<Waypoint*> &, char *);
-	void label_invalid_char();
+	struct LabelContext
+	{	// what label_datachecks needs to know about a Route, worked out once
+		std::string rte_ban;	// route & banner
+		const char *route_num;	// route's trailing digits, or 0 if there are none
+		bool usa;
+		LabelContext(Route *, bool);
+	};
 	bool label_too_long();
-	void out_of_bounds(char *);
-	// checks for visible points
-	void bus_with_i();
-	void interstate_no_hyphen();
-	void label_invalid_ends();
-	void label_looks_hidden();
-	void label_parens();
-	void label_selfref(const char *);
-	void label_slashes(const char *);
-	void lacks_generic();
-	void underscore_datachecks(const char *);
-	void us_letter();
-	void visible_distance(char *, double &, Waypoint *&);
+	void label_datachecks(LabelContext &);
 };
@@ -0,0 +1,16 @@
+#include <cstdint>
+#include <cstring>
+
+inline uint64_t coord_hash(double lat, double lng)
+{	/* hash of a coordinate pair, for tables keyed on exact location.
+	-0.0 becomes 0.0, so coordinates that compare equal hash equal.
+	Inline, as it's called for every point in Colocation's bucket &
+	group loops and in Route::duplicate_coords. */
+	lat += 0.0;
+	lng += 0.0;
+	uint64_t a, b;
+	memcpy(&a, &lat, sizeof(a));
+	memcpy(&b, &lng, sizeof(b));
+	uint64_t h = (a ^ b * 0x9E3779B97F4A7C15ULL) * 0xFF51AFD7ED558CCDULL;
+	return h ^ h >> 29;
+}
@@ -1,28 +1,131 @@
 #include "crawl_hwy_data.h"
+#include "../classes/Route/Route.h"
+#include <algorithm>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
-void crawl_hwy_data(std::string path, std::unordered_set<std::string> &all_wpt_files, std::unordered_set<std::string> &splitsystems, std::string &splitregion, bool get_ss)
-{	DIR *dir;
-	dirent *ent;
+int HwyDataCrawl::root_fd = -1;
+std::string HwyDataCrawl::splitregion;
+std::vector<HwyDataCrawl::Subtree> HwyDataCrawl::subtrees;
+std::vector<std::string> HwyDataCrawl::root_files;
+std::mutex HwyDataCrawl::mtx;
+size_t HwyDataCrawl::next_subtree = 0;
+
+static unsigned char entry_type(int dirfd, dirent *ent)
+{	// d_type if we have it, else ask the filesystem
+	if (ent->d_type != DT_UNKNOWN && ent->d_type != DT_LNK) return ent->d_type;
 	struct stat buf;
-	if ((dir = opendir (path.data())) != NULL)
-	{	while ((ent = readdir (dir)) != NULL)
-		{	std::string entry = (path + "/") + ent->d_name;
-			stat(entry.data(), &buf);
-			if (S_ISDIR(buf.st_mode))
-			{    if (strcmp(ent->d_name, ".") && strcmp(ent->d_name, "..") && strcmp(ent->d_name, "_boundaries"))
-			     {	if (get_ss)
-				{	splitsystems.insert(ent->d_name);
-					splitsystems.insert(std::string(ent->d_name)+'r');
+	if (fstatat(dirfd, ent->d_name, &buf, 0)) return DT_UNKNOWN;
+	return S_ISDIR(buf.st_mode) ? DT_DIR : DT_REG;
+}
+
+static bool crawlable(const char *name)
+{	return strcmp(name, ".") && strcmp(name, "..") && strcmp(name, "_boundaries");
+}
+
+static bool is_wpt(const char *name)
+{	size_t len = strlen(name);
+	return len >= 4 && !strcmp(name+len-4, ".wpt");
+}
+
+bool HwyDataCrawl::list_regions(std::string path, std::string &sr)
+{	/* open hwy_data & list its subdirectories, to be crawled later;
+	return false if it can't be opened */
+	splitregion = sr;
+	root_fd = open(path.data(), O_RDONLY | O_DIRECTORY);
+	if (root_fd < 0) return 0;
+	DIR *dir = fdopendir(dup(root_fd));
+	if (!dir)
+	{	close(root_fd);
+		root_fd = -1;
+		return 0;
+	}
+	while (dirent *ent = readdir(dir))
+	  switch (entry_type(dirfd(dir), ent))
+	  {	case DT_DIR:
+			if (crawlable(ent->d_name))
+			{	subtrees.emplace_back();
+				subtrees.back().name = ent->d_name;
+				subtrees.back().get_ss = splitregion == ent->d_name;
+			}
+			break;
+		default:
+			if (is_wpt(ent->d_name)) root_files.emplace_back(ent->d_name);
+	  }
+	closedir(dir);
+	std::sort(subtrees.begin(), subtrees.end(), [](const Subtree &a, const Subtree &b){return a.name < b.name;});
+	next_subtree = 0;
+	return 1;
+}
+
+bool HwyDataCrawl::next(size_t &s)
+{	/* get the index of the next subtree to crawl;
+	return false when they're all spoken for */
+	mtx.lock();
+	s = next_subtree;
+	bool found = next_subtree < subtrees.size();
+	if (found) next_subtree++;
+	mtx.unlock();
+	return found;
+}
+
+void HwyDataCrawl::crawl(size_t s)
+{	Subtree &st = subtrees[s];
+	int fd = openat(root_fd, st.name.data(), O_RDONLY | O_DIRECTORY);
+	if (fd >= 0) crawl_dir(fd, st.name, st, st.get_ss);
+}
+
+void HwyDataCrawl::crawl_dir(int fd, std::string path, Subtree &st, bool get_ss)
+{	/* crawl the directory open as fd, then close it */
+	DIR *dir = fdopendir(fd);
+	if (!dir)
+	{	close(fd);
+		return;
+	}
+	std::vector<std::string> files;
+	while (dirent *ent = readdir(dir))
+	  switch (entry_type(fd, ent))
+	  {	case DT_DIR:
+			if (crawlable(ent->d_name))
+			{	if (get_ss)
+				{	st.splitsystems.insert(ent->d_name);
+					st.splitsystems.insert(std::string(ent->d_name)+'r');
 				}
-				crawl_hwy_data(entry, all_wpt_files, splitsystems, splitregion, splitregion==ent->d_name);
-			     }
+				int subfd = openat(fd, ent->d_name, O_RDONLY | O_DIRECTORY);
+				if (subfd >= 0) crawl_dir(subfd, path + '/' + ent->d_name, st, splitregion == ent->d_name);
 			}
-			else if (entry.substr(entry.size()-4) == ".wpt")
-				all_wpt_files.insert(entry);
+			break;
+		default:
+			if (is_wpt(ent->d_name)) files.emplace_back(ent->d_name);
+	  }
+	closedir(dir);
+	if (files.size()) st.dirs.emplace_back(path, std::move(files));
+}
+
+size_t HwyDataCrawl::collect(std::unordered_set<std::string> &splitsystems)
+{	/* once every subtree is crawled, number the directories & move
+	their files into Route::all_wpt_files; return the number of files */
+	size_t count = root_files.size();
+	if (root_files.size())
+	{	Route::wpt_dir_ids[""] = Route::wpt_dirs.size();
+		Route::wpt_dirs.emplace_back();
+		Route::all_wpt_files.emplace_back(root_files.begin(), root_files.end());
+	}
+	for (Subtree &st : subtrees)
+	{	for (auto &d : st.dirs)
+		{	Route::wpt_dir_ids[d.first] = Route::wpt_dirs.size();
+			Route::wpt_dirs.push_back(std::move(d.first));
+			Route::all_wpt_files.emplace_back(d.second.begin(), d.second.end());
+			count += d.second.size();
 		}
-		closedir(dir);
+		splitsystems.insert(st.splitsystems.begin(), st.splitsystems.end());
 	}
+	subtrees.clear();
+	root_files.clear();
+	if (root_fd >= 0) close(root_fd);
+	root_fd = -1;
+	return count;
 }
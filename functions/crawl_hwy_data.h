@@ -1,4 +1,38 @@
+#include <mutex>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
-void crawl_hwy_data(std::string, std::unordered_set<std::string>&, std::unordered_set<std::string>&, std::string&, bool);
+class HwyDataCrawl
+{	/* Finds every .wpt file in the hwy_data tree.
+
+	Entries are classified by readdir's d_type, with fstatat only
+	when the filesystem doesn't fill that in (or for symlinks, which
+	are followed as before). Directories are opened relative to their
+	parent with openat, so no full path strings are built.
+
+	list_regions reads the top level; each region's subtree is then
+	crawled independently, by whichever thread takes it from next.
+	collect assigns each directory holding .wpt files an id in region
+	order, no matter which thread crawled it, and files are stored as
+	(dir id, name) pairs in Route::all_wpt_files. */
+	struct Subtree
+	{	std::string name;	// region directory
+		bool get_ss;		// whether this is the split region
+		std::vector<std::pair<std::string, std::vector<std::string>>> dirs; // relative path, .wpt files
+		std::unordered_set<std::string> splitsystems;
+	};
+	static int root_fd;
+	static std::string splitregion;
+	static std::vector<Subtree> subtrees;
+	static std::vector<std::string> root_files;
+	static std::mutex mtx;		// for locking next_subtree
+	static size_t next_subtree;
+
+	static void crawl_dir(int, std::string, Subtree &, bool);
+	public:
+	static bool list_regions(std::string, std::string &);
+	static bool next(size_t &);
+	static void crawl(size_t);
+	static size_t collect(std::unordered_set<std::string> &);
+};
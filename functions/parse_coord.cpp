@@ -0,0 +1,44 @@
+#include "parse_coord.h"
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+// every power of 10 that a double represents exactly
+static const double p10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+const char *parse_coord(const char *c, const char *end, double &value)
+{	/* validate & convert the URL argument at c, which runs up to the
+	next '&', NUL or end. It must be an optional leading minus sign,
+	then digits with at most one decimal point. Return 0 if it's not,
+	else where it stops, with value set as strtod would set it.
+
+	Up to 19 significant digits are gathered into an integer as we go.
+	If that's at most 2^53 and there are at most 22 decimal places,
+	both it and the power of 10 are exact doubles, and one division
+	rounds the quotient correctly, same as strtod. Longer numbers, rare
+	in practice, are left to strtod itself. */
+	const char *p = c;
+	bool neg = p < end && *p == '-';
+	uint64_t mantissa = 0;
+	unsigned int sig_digits = 0, decimals = 0;
+	bool point = 0, digits = 0, overflow = 0;
+	for (p += neg; p < end && *p && *p != '&'; p++)
+	  if (*p >= '0' && *p <= '9')
+	  {	digits = 1;
+		decimals += point;
+		if (mantissa || *p != '0')
+		  if (++sig_digits > 19) overflow = 1;
+		  else mantissa = mantissa*10 + (*p-'0');
+	  }
+	  else if (*p == '.' && !point) point = 1;
+	  else return 0;
+	if (p == c) return 0;				// empty
+	if (!digits) value = 0;				// just "-", "." or "-."; strtod converts nothing
+	else if (!overflow && mantissa <= 1ULL<<53 && decimals <= 22)
+	{	value = mantissa / p10[decimals];
+		if (neg) value = -value;
+	}
+	else	value = strtod(std::string(c, p).data(), 0);
+	return p;
+}
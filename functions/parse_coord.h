@@ -0,0 +1 @@
+const char *parse_coord(const char*, const char*, double&);
@@ -1,39 +1,143 @@
 #include "threads.h"
+#include "../classes/Colocation/Colocation.h"
+#include "../classes/Datacheck/Datacheck.h"
+#include "../classes/ErrorList/ErrorList.h"
 #include "../classes/HighwaySystem/HighwaySystem.h"
+#include "../classes/Metrics/Metrics.h"
+#include "../classes/Progress/Progress.h"
 #include "../classes/Route/Route.h"
+#include "../classes/Snapshot/Snapshot.h"
+#include "../classes/Trace/Trace.h"
 #include "../classes/TravelerList/TravelerList.h"
-#include <iostream>
+#include "crawl_hwy_data.h"
+#include <algorithm>
 
-#define debug
-void ReadWptThread(unsigned int id, std::mutex* hs_mtx, ErrorList* el)
-{	//printf("Starting ReadWptThread %02i\n", id); fflush(stdout);
-	while (HighwaySystem::it != HighwaySystem::syslist.end())
-	{	hs_mtx->lock();
-		if (HighwaySystem::it == HighwaySystem::syslist.end())
-		{	hs_mtx->unlock();
-			return;
+std::vector<RouteDeque> RouteDeque::deques;
+
+void RouteDeque::seed(unsigned int numthreads)
+{	/* Deal every Route out to numthreads deques. With a snapshot, the
+	largest .wpt files go first, by the sizes its entries recorded;
+	files with no entry sort last. Without one, crawl_hwy_data doesn't
+	stat files, so Routes go in system order, and stealing evens out
+	whatever imbalance remains. */
+	std::vector<std::pair<uint64_t, Route*>> by_size;
+	for (HighwaySystem *h : HighwaySystem::syslist)
+	  for (Route *r : h->route_list)
+	  {	std::string path;
+		if (Snapshot::enabled) path = r->rg_str + "/" + h->systemname + "/" + r->root + ".wpt";
+		by_size.emplace_back(Snapshot::enabled ? Snapshot::file_size(path) : 0, r);
+	  }
+	if (Snapshot::enabled)
+		std::stable_sort(by_size.begin(), by_size.end(),
+				 [](const std::pair<uint64_t, Route*>& a, const std::pair<uint64_t, Route*>& b){return a.first > b.first;});
+	deques = std::vector<RouteDeque>(numthreads);
+	for (size_t i = 0; i < by_size.size(); i++)
+		deques[i % numthreads].routes.push_back(by_size[i].second);
+}
+
+Route* RouteDeque::next(unsigned int id)
+{	/* return the next Route for thread id to read, or 0 when all deques are empty */
+	Route *r = 0;
+	RouteDeque &own = deques[id];
+	own.mtx.lock();
+	if (own.routes.size())
+	{	r = own.routes.front();
+		own.routes.pop_front();
+	}
+	own.mtx.unlock();
+	// steal from the back, where the smallest files are when sizes are known
+	for (size_t v = 1; !r && v < deques.size(); v++)
+	{	RouteDeque &victim = deques[(id+v) % deques.size()];
+		victim.mtx.lock();
+		if (victim.routes.size())
+		{	r = victim.routes.back();
+			victim.routes.pop_back();
 		}
-		HighwaySystem* h(*HighwaySystem::it);
-		//printf("ReadWptThread %02i assigned %s\n", id, h->systemname.data()); fflush(stdout);
-		HighwaySystem::it++;
-	      #ifdef debug
-		HighwaySystem::in_flight[id] = h;
-		TravelerList::mtx.lock();
-		for (HighwaySystem* sys : HighwaySystem::in_flight)
-		  if (sys)
-		  {	std::cout << "| " << sys->systemname;
-			for (size_t i = sys->systemname.size(); i < 11; i++)
-			  std::cout << ' '; // pad to 11 chars with spaces
-		  }
-		  else std::cout << "           ";
-		std::cout << " |" << std::endl;
-		TravelerList::mtx.unlock();
-	      #endif
-		hs_mtx->unlock();
-		std::cout << h->systemname << std::flush;
-		bool usa_flag = h->country->first == "USA";
-		for (Route *r : h->route_list)
-			r->read_wpt(id, el, usa_flag);
-		std::cout << "!" << std::endl;
+		victim.mtx.unlock();
+	}
+	return r;
+}
+
+void NewHighwaySystemThread(std::mutex *mtx, size_t *next, std::vector<std::string> *lines,
+			    std::vector<HighwaySystem*> *systems, std::vector<std::pair<std::string,std::string>> *countries)
+{	/* construct HighwaySystems from systems.csv lines, taking the next unclaimed line each time */
+	Metrics::ThreadTimer timer;
+	for (;;)
+	{	mtx->lock();
+		size_t i = (*next)++;
+		mtx->unlock();
+		if (i >= lines->size()) return;
+		(*systems)[i] = new HighwaySystem((*lines)[i], *countries);
+			       // deleted on termination of program
+	}
+}
+
+void CrawlHwyDataThread()
+{	Metrics::ThreadTimer timer;
+	size_t s;
+	while (HwyDataCrawl::next(s)) HwyDataCrawl::crawl(s);
+}
+
+void ReadWptThread(unsigned int id, ErrorList* el)
+{	//printf("Starting ReadWptThread %02i\n", id); fflush(stdout);
+	Metrics::ThreadTimer timer;
+	TRACE(HighwaySystem *sys = 0; uint64_t sys_begin = 0;)
+	while (Route *r = RouteDeque::next(id))
+	{	//printf("ReadWptThread %02i assigned %s\n", id, r->root.data()); fflush(stdout);
+		// a system span covers each run of Routes from the same system
+		TRACE(if (r->system != sys)
+		      {	uint64_t t = Trace::now();
+			if (sys) Trace::record("system", sys->systemname.data(), sys_begin, t);
+			sys = r->system;
+			sys_begin = t;
+		      })
+		TRACE_SPAN("route", r->root.data());
+		Progress::reading(id, r);
+		ErrorList::order = r->index;
+		r->read_wpt(id, el, r->system->country->first == "USA");
+		Progress::done(id);
 	}
+	TRACE(if (sys) Trace::record("system", sys->systemname.data(), sys_begin, Trace::now());)
+}
+
+void ProgressThread()
+{	while (Progress::wait()) Progress::draw();
+}
+
+void ReadListThread(std::mutex *mtx, size_t *next, std::vector<std::string> *ids, ErrorList *el)
+{	/* process .list files, taking the next unclaimed one each time */
+	Metrics::ThreadTimer timer;
+	for (;;)
+	{	mtx->lock();
+		size_t i = (*next)++;
+		mtx->unlock();
+		if (i >= ids->size()) return;
+		ErrorList::order = i;
+		TravelerList::allusers[i] = new TravelerList((*ids)[i], el);
+					    // deleted on termination of program
+	}
+}
+
+void ColocationBucketThread(unsigned int id, unsigned int numthreads)
+{	Metrics::ThreadTimer timer;
+	for (size_t c = id; c < Colocation::chunks; c += numthreads)
+		Colocation::bucket(c);
+}
+
+void ColocationGroupThread(unsigned int id, unsigned int numthreads)
+{	Metrics::ThreadTimer timer;
+	for (size_t s = id; s < Colocation::shards; s += numthreads)
+		Colocation::group(s);
+}
+
+void DatacheckSortThread(unsigned int id, unsigned int numthreads)
+{	Metrics::ThreadTimer timer;
+	for (size_t b = id; b < Datacheck::buffers.size(); b += numthreads)
+		Datacheck::sort_buffer(b);
+}
+
+void DatacheckMergeThread(unsigned int id, unsigned int numthreads)
+{	Metrics::ThreadTimer timer;
+	for (size_t p = id; p < Datacheck::parts; p += numthreads)
+		Datacheck::merge_part(p);
 }
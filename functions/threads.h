@@ -1,3 +1,31 @@
 class ErrorList;
+class HighwaySystem;
+class Route;
+#include <deque>
 #include <mutex>
-void ReadWptThread(unsigned int, std::mutex*, ErrorList*);
+#include <string>
+#include <vector>
+
+class RouteDeque
+{	/* One ReadWptThread's share of the Routes whose .wpt files are
+	to be read. The owner pops from the front; a thread whose own
+	deque has run dry steals from the back of someone else's. */
+	public:
+	std::mutex mtx;
+	std::deque<Route*> routes;
+
+	static std::vector<RouteDeque> deques;
+	static void seed(unsigned int);
+	static Route* next(unsigned int);
+};
+
+void NewHighwaySystemThread(std::mutex*, size_t*, std::vector<std::string>*,
+			    std::vector<HighwaySystem*>*, std::vector<std::pair<std::string,std::string>>*);
+void CrawlHwyDataThread();
+void ReadWptThread(unsigned int, ErrorList*);
+void ProgressThread();
+void ReadListThread(std::mutex*, size_t*, std::vector<std::string>*, ErrorList*);
+void ColocationBucketThread(unsigned int, unsigned int);
+void ColocationGroupThread(unsigned int, unsigned int);
+void DatacheckSortThread(unsigned int, unsigned int);
+void DatacheckMergeThread(unsigned int, unsigned int);
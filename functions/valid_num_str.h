@@ -1 +0,0 @@
-bool valid_num_str(const char*, const char);
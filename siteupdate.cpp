@@ -15,17 +15,24 @@ This module defines classes to represent the contents of a
 
 #include <cstring>
 #include <dirent.h>
+#include <fstream>
 #include <thread>
+#include "classes/Arena/Arena.h"
 #include "classes/Args/Args.h"
-#include "classes/DBFieldLength/DBFieldLength.h"
+#include "classes/Colocation/Colocation.h"
 #include "classes/ConnectedRoute/ConnectedRoute.h"
 #include "classes/Datacheck/Datacheck.h"
 #include "classes/ElapsedTime/ElapsedTime.h"
 #include "classes/ErrorList/ErrorList.h"
 #include "classes/HighwaySegment/HighwaySegment.h"
 #include "classes/HighwaySystem/HighwaySystem.h"
+#include "classes/Metrics/Metrics.h"
+#include "classes/NameTable/NameTable.h"
+#include "classes/Progress/Progress.h"
 #include "classes/Region/Region.h"
 #include "classes/Route/Route.h"
+#include "classes/Snapshot/Snapshot.h"
+#include "classes/Trace/Trace.h"
 #include "classes/TravelerList/TravelerList.h"
 #include "classes/Waypoint/Waypoint.h"
 #include "functions/crawl_hwy_data.h"
@@ -43,12 +50,17 @@ int main(int argc, char *argv[])
 
 	// argument parsing
 	if (Args::init(argc, argv)) return 1;
+	if ((Args::changedfiles.size() || Args::changedlistfile.size()) && Args::snapshotfile.empty())
+	{	cout << "Incremental mode (-i, -I) needs a snapshot (-S) to work from." << endl;
+		return 1;
+	}
       #ifndef threading_enabled
 	Args::numthreads = 1;
       #endif
 
 	// start a timer for including elapsed time reports in messages
 	ElapsedTime et(Args::timeprecision);
+	Metrics::start(&et);
 	time_t timestamp = time(0);
 	cout << "Start: " << ctime(&timestamp);
 
@@ -74,6 +86,7 @@ int main(int argc, char *argv[])
 
 	// read region, country, continent descriptions
 	cout << et.et() << "Reading region, country, and continent descriptions." << endl;
+	Metrics::phase("descriptions");
 
 	// continents
 	vector<pair<string, string>> continents;
@@ -154,23 +167,32 @@ int main(int argc, char *argv[])
 			if (line.empty()) continue;
 			Region* r = new Region(line, countries, continents, el);
 				    // deleted on termination of program
-			if (r->is_valid)
-			{	Region::allregions.push_back(r);
-				Region::code_hash[r->code] = r;
-			} else	delete r;
+			if (r->is_valid) Region::allregions.push_back(r);
+			else	delete r;
 		}
 	     }
 	file.close();
 	// create a dummy region to catch unrecognized region codes in .csv files
 	Region::allregions.push_back(new Region("error;unrecognized region code;error;error;unrecognized region code", countries, continents, el));
-	Region::code_hash[Region::allregions.back()->code] = Region::allregions.back();
+	// hash region codes, last first so that the last of any repeated code wins
+	Region::code_hash.reserve(Region::allregions.size());
+	for (auto r = Region::allregions.rbegin(); r != Region::allregions.rend(); r++)
+		Region::code_hash.insert((*r)->code, *r);
+	el.flush();
+
+      #ifdef threading_enabled
+	std::vector<std::thread> thr(Args::numthreads);
+	#define THREADLOOP for (unsigned int t = 0; t < thr.size(); t++)
+      #endif
 
 	// Create a list of HighwaySystem objects, one per system in systems.csv file
 	cout << et.et() << "Reading systems list in " << Args::highwaydatapath << "/" << Args::systemsfile << "." << endl;
+	Metrics::phase("systems");
 	file.open(Args::highwaydatapath+"/"+Args::systemsfile);
 	if (!file) el.add_error("Could not open "+Args::highwaydatapath+"/"+Args::systemsfile);
 	else {	getline(file, line); // ignore header line
 		list<string> ignoring;
+		vector<string> syslines;
 		while(getline(file, line))
 		{	if (line.back() == 0x0D) line.erase(line.end()-1);	// trim DOS newlines
 			if (line.empty()) continue;
@@ -178,13 +200,42 @@ int main(int argc, char *argv[])
 			{	ignoring.push_back("Ignored comment in " + Args::systemsfile + ": " + line);
 				continue;
 			}
-			HighwaySystem *hs = new HighwaySystem(line, el, countries);
-					    // deleted on termination of program
+			syslines.push_back(line);
+		}
+		// construct systems in parallel...
+		Metrics::begin("construct");
+		vector<HighwaySystem*> systems(syslines.size());
+	      #ifdef threading_enabled
+		size_t next_sys = 0;
+		mutex sys_mtx;
+		THREADLOOP thr[t] = thread(NewHighwaySystemThread, &sys_mtx, &next_sys, &syslines, &systems, &countries);
+		THREADLOOP thr[t].join();
+	      #else
+		for (size_t i = 0; i < syslines.size(); i++)
+			systems[i] = new HighwaySystem(syslines[i], countries);
+	      #endif
+		// ...then finish them in order
+		Metrics::end();
+		Metrics::begin("insert routes");
+		size_t routes = 0, alt_names = 0;
+		for (HighwaySystem *hs : systems)
+		{	routes += hs->route_list.size();
+			for (Route *r : hs->route_list) alt_names += r->alt_route_names.size();
+		}
+		Route::root_hash.reserve(routes);
+		Route::pri_list_hash.reserve(routes);
+		Route::alt_list_hash.reserve(alt_names);
+		size_t index = 0;
+		for (HighwaySystem *hs : systems)
+		{	hs->insert_routes(el);
 			if (!hs->is_valid) delete hs;
 			else {	HighwaySystem::syslist.push_back(hs);
+				for (Route *r : hs->route_list) r->index = index++;
 			     }
 		}
 		cout << endl;
+		el.flush();
+		Metrics::end();
 		// at the end, print the lines ignored
 		for (string& l : ignoring) cout << l << endl;
 		ignoring.clear();
@@ -195,29 +246,180 @@ int main(int argc, char *argv[])
 	// that do not have a .csv file entry that causes them to be
 	// read into the data
 	cout << et.et() << "Finding all .wpt files. " << flush;
+	Metrics::phase("find .wpt files");
 	unordered_set<string> splitsystems;
-	crawl_hwy_data(Args::highwaydatapath+"/hwy_data", Route::all_wpt_files, splitsystems, Args::splitregion, 0);
-	cout << Route::all_wpt_files.size() << " files found." << endl;
+	if (HwyDataCrawl::list_regions(Args::highwaydatapath+"/hwy_data", Args::splitregion))
+	{
+	      #ifdef threading_enabled
+		THREADLOOP thr[t] = thread(CrawlHwyDataThread);
+		THREADLOOP thr[t].join();
+	      #else
+		size_t s;
+		while (HwyDataCrawl::next(s)) HwyDataCrawl::crawl(s);
+	      #endif
+	}
+	cout << HwyDataCrawl::collect(splitsystems) << " files found." << endl;
+
+	// Data from the last run's snapshot can stand in for unchanged .wpt files
+	if (Args::snapshotfile.size())
+	{	cout << et.et() << "Loading snapshot " << Args::snapshotfile << ". " << flush;
+		Metrics::phase("load snapshot");
+		cout << Snapshot::load(Args::snapshotfile) << " entries found." << endl;
+	}
+	// In incremental mode, that goes for every .wpt file not listed as changed
+	if (Args::changedfiles.size() || Args::changedlistfile.size())
+	{	cout << et.et() << "Incremental mode: " << flush;
+		Metrics::phase("list changed files");
+		cout << Snapshot::list_changed(Args::changedfiles, Args::changedlistfile, Args::highwaydatapath, el)
+		     << " changed files listed." << endl;
+		el.flush();
+	}
 
 	// Next, read all of the .wpt files for each HighwaySystem
 	cout << et.et() << "Reading waypoints for all routes." << endl;
+	Metrics::phase("read waypoints");
+	size_t routes = 0;
+	for (HighwaySystem* h : HighwaySystem::syslist) routes += h->route_list.size();
       #ifdef threading_enabled
-	HighwaySystem::in_flight.assign(Args::numthreads,0);
-	std::vector<std::thread> thr(Args::numthreads);
-	HighwaySystem::it = HighwaySystem::syslist.begin();
-	#define THREADLOOP for (unsigned int t = 0; t < thr.size(); t++)
-	THREADLOOP thr[t] = thread(ReadWptThread, t, &list_mtx, &el);
+	RouteDeque::seed(Args::numthreads);
+	thread reporter;
+	if (Progress::start(routes, Args::numthreads)) reporter = thread(ProgressThread);
+	THREADLOOP thr[t] = thread(ReadWptThread, t, &el);
 	THREADLOOP thr[t].join();
-	HighwaySystem::in_flight.clear();
+	Progress::stop();
+	if (reporter.joinable()) reporter.join();
+	RouteDeque::deques.clear();
       #else
+	Progress::start(routes, 1);
 	for (HighwaySystem* h : HighwaySystem::syslist)
-	{	std::cout << h->systemname << std::flush;
+	{	TRACE_SPAN("system", h->systemname.data());
 		bool usa_flag = h->country->first == "USA";
 		for (Route* r : h->route_list)
-			r->read_wpt(0, &all_waypoints, &el, usa_flag);
-		std::cout << "!" << std::endl;
+		{	TRACE_SPAN("route", r->root.data());
+			Progress::reading(0, r);
+			r->read_wpt(0, &el, usa_flag);
+			Progress::done(0);
+			Progress::tick();
+		}
 	}
       #endif
+	Progress::finish();
+	el.flush();
+
+	if (Snapshot::enabled)
+	{	cout << et.et() << "Writing snapshot " << Args::snapshotfile << '.' << endl;
+		Metrics::phase("write snapshot");
+		if (!Snapshot::write(Args::snapshotfile))
+			cout << "Could not write " << Args::snapshotfile << endl;
+	}
+
+	cout << et.et() << "Finding colocated points." << endl;
+	Metrics::phase("colocated points");
+      #ifdef threading_enabled
+	Colocation::setup(4*thr.size());
+	Metrics::begin("bucket");
+	THREADLOOP thr[t] = thread(ColocationBucketThread, t, thr.size());
+	THREADLOOP thr[t].join();
+	Metrics::end();
+	Metrics::begin("group");
+	THREADLOOP thr[t] = thread(ColocationGroupThread, t, thr.size());
+	THREADLOOP thr[t].join();
+	Metrics::end();
+      #else
+	Colocation::setup(1);
+	Metrics::begin("bucket");
+	Colocation::bucket(0);
+	Metrics::end();
+	Metrics::begin("group");
+	for (size_t s = 0; s < Colocation::shards; s++)
+		Colocation::group(s);
+	Metrics::end();
+      #endif
+	cout << et.et() << Colocation::total() << " locations with colocated points." << endl;
+
+	// Create a list of TravelerList objects, one per person
+	cout << et.et() << "Processing traveler list files." << endl;
+	Metrics::phase("traveler lists");
+	TravelerList::ids.sort();
+	vector<string> ids(TravelerList::ids.begin(), TravelerList::ids.end());
+	TravelerList::allusers.resize(ids.size());
+      #ifdef threading_enabled
+	size_t next_list = 0;
+	THREADLOOP thr[t] = thread(ReadListThread, &list_mtx, &next_list, &ids, &el);
+	THREADLOOP thr[t].join();
+      #else
+	for (size_t i = 0; i < ids.size(); i++)
+		TravelerList::allusers[i] = new TravelerList(ids[i], &el);
+				    // deleted on termination of program
+      #endif
+	el.flush();
+	cout << et.et() << "Processed " << ids.size() << " traveler list files." << endl;
+
+	cout << et.et() << "Sorting and merging datachecks." << endl;
+	Metrics::phase("datachecks");
+      #ifdef threading_enabled
+	Metrics::begin("sort");
+	THREADLOOP thr[t] = thread(DatacheckSortThread, t, thr.size());
+	THREADLOOP thr[t].join();
+	Metrics::end();
+	Metrics::begin("merge");
+	Datacheck::partition(thr.size());
+	THREADLOOP thr[t] = thread(DatacheckMergeThread, t, thr.size());
+	THREADLOOP thr[t].join();
+	Metrics::end();
+      #else
+	Metrics::begin("sort");
+	for (size_t b = 0; b < Datacheck::buffers.size(); b++)
+		Datacheck::sort_buffer(b);
+	Metrics::end();
+	Metrics::begin("merge");
+	Datacheck::partition(1);
+	Datacheck::merge_part(0);
+	Metrics::end();
+      #endif
+	Datacheck::collect();
+	cout << et.et() << "Writing " << Datacheck::errors.size() << " datachecks to " << Args::logfilepath << "/datacheck.log." << endl;
+	if (!Datacheck::write(Args::logfilepath+"/datacheck.log"))
+		cout << "Could not write " << Args::logfilepath << "/datacheck.log" << endl;
+
+	// report memory per waypoint: the object & its labels as the Arena
+	// rounds them, and the coordinate & point_list vectors, slack included.
+	// Labels restored from a snapshot stay in its mapping, not the Arena.
+	size_t points = 0, object_bytes = 0, vector_bytes = 0, label_bytes = 0, mapped_bytes = 0;
+	for (HighwaySystem *h : HighwaySystem::syslist)
+	  for (Route *r : h->route_list)
+	  {	points += r->point_list.size();
+		object_bytes += r->point_list.size() * Arena::rounded(sizeof(Waypoint));
+		vector_bytes += (r->lat.capacity() + r->lng.capacity()) * sizeof(double)
+			      + r->point_list.capacity() * sizeof(Waypoint*);
+		for (Waypoint *w : r->point_list)
+		  if (Snapshot::holds(w->label)) mapped_bytes += w->labels_size();
+		  else	label_bytes += Arena::rounded(w->labels_size());
+	  }
+	if (points)
+	{	cout << et.et() << "Memory per waypoint: " << double(object_bytes+vector_bytes+label_bytes)/points
+		     << " bytes (" << double(object_bytes)/points << " object, " << double(vector_bytes)/points
+		     << " coordinates & point_list, " << double(label_bytes)/points << " labels) for "
+		     << points << " waypoints";
+		if (mapped_bytes) cout << ", plus " << double(mapped_bytes)/points << " bytes of labels mapped from the snapshot";
+		cout << '.' << endl;
+	}
+
+      #ifdef tracing_enabled
+	cout << et.et() << "Writing trace to " << Args::logfilepath << "/trace.json." << endl;
+	if (!Trace::write(Args::logfilepath+"/trace.json"))
+		cout << "Could not write " << Args::logfilepath << "/trace.json" << endl;
+      #endif
+
+	// report Arena usage, then free every Arena at once
+	cout << et.et() << "Arena usage:" << endl;
+	for (size_t a = 0; a < Arena::arenas.size(); a++)
+		cout << "  " << a << ": " << Arena::arenas[a]->objects << " objects, " << Arena::arenas[a]->bytes << " bytes" << endl;
+	Arena::release_all();
+
+	// write the phase timing & counters report
+	if (!Metrics::write(Args::logfilepath+"/siteupdate.json"))
+		cout << "Could not write " << Args::logfilepath << "/siteupdate.json" << endl;
 
 	timestamp = time(0);
 	cout << "Finish: " << ctime(&timestamp);